@@ -0,0 +1,103 @@
+#define _GNU_SOURCE
+#include "affinity.h"
+#include "topology.h"
+#include <sched.h>
+#include <stdlib.h>
+
+
+typedef struct {
+   int cpu;
+   int package;
+   int core;
+   int smt;       // rank among the hardware threads of its core
+   int core_rank; // rank of its core within the package
+} CpuInfo;
+
+
+static int cmp_scatter(const void* a, const void* b) {
+   const CpuInfo* x = a;
+   const CpuInfo* y = b;
+   if (x->smt != y->smt) return x->smt - y->smt;
+   if (x->core_rank != y->core_rank) return x->core_rank - y->core_rank;
+   return x->package - y->package;
+}
+
+
+// Allowed CPUs of the process in compact order, with SMT and core ranks
+// counted over the allowed set only.
+static int allowed_cpus(CpuInfo** out) {
+   cpu_set_t set;
+   if (sched_getaffinity(0, sizeof(set), &set) != 0) return 0;
+  
+   const Topology* topo = topology_get();
+   int n = 0;
+   CpuInfo* cpus = malloc(sizeof(CpuInfo) * (topo->ncpus > 0 ? topo->ncpus : 1));
+   for (int i = 0; i < topo->ncpus; i++) {
+       const TopoCpu* tc = &topo->cpus[i];
+       if (tc->cpu >= CPU_SETSIZE || !CPU_ISSET(tc->cpu, &set)) continue;
+       cpus[n].cpu = tc->cpu;
+       cpus[n].package = tc->domain[TOPO_PACKAGE];
+       cpus[n].core = tc->domain[TOPO_CORE];
+       n++;
+   }
+  
+   for (int i = 0; i < n; i++) {
+       if (i > 0 && cpus[i].core == cpus[i - 1].core) {
+           cpus[i].smt = cpus[i - 1].smt + 1;
+           cpus[i].core_rank = cpus[i - 1].core_rank;
+       } else {
+           cpus[i].smt = 0;
+           cpus[i].core_rank = (i > 0 && cpus[i].package == cpus[i - 1].package) ? cpus[i - 1].core_rank + 1 : 0;
+       }
+   }
+   *out = cpus;
+   return n;
+}
+
+
+int affinity_plan(const PlacementConfig* config, int nworkers, int* out) {
+   if (!config || config->policy == PLACEMENT_NONE) {
+       for (int w = 0; w < nworkers; w++) out[w] = -1;
+       return 0;
+   }
+  
+   CpuInfo* cpus = NULL;
+   int n = allowed_cpus(&cpus);
+   int result = 0;
+  
+   if (config->policy == PLACEMENT_EXPLICIT) {
+       cpu_set_t set;
+       CPU_ZERO(&set);
+       for (int i = 0; i < n; i++) CPU_SET(cpus[i].cpu, &set);
+       if (config->ncpus <= 0) result = -1;
+       for (int i = 0; i < config->ncpus && result == 0; i++) {
+           int c = config->cpus[i];
+           if (c < 0 || c >= CPU_SETSIZE || !CPU_ISSET(c, &set)) result = -1;
+       }
+       for (int w = 0; w < nworkers && result == 0; w++) out[w] = config->cpus[w % config->ncpus];
+   } else if (n == 0) {
+       result = -1;
+   } else {
+       if (config->policy == PLACEMENT_SCATTER) {
+           qsort(cpus, n, sizeof(CpuInfo), cmp_scatter);
+       } else if (config->policy == PLACEMENT_PHYSICAL_CORES) {
+           int m = 0;
+           for (int i = 0; i < n; i++) {
+               if (cpus[i].smt == 0) cpus[m++] = cpus[i];
+           }
+           n = m;
+       }
+       for (int w = 0; w < nworkers; w++) out[w] = cpus[w % n].cpu;
+   }
+  
+   free(cpus);
+   return result;
+}
+
+
+int affinity_pin_self(int cpu) {
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   return sched_setaffinity(0, sizeof(set), &set);
+}
@@ -0,0 +1,30 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+// Worker placement. A plan maps every worker to one CPU of the process's
+// allowed set, ordered by the topology module; workers pin themselves with
+// sched_setaffinity. When there are more workers than CPUs in the plan,
+// the mapping wraps around.
+
+typedef enum {
+   PLACEMENT_NONE,            // leave placement to the OS
+   PLACEMENT_COMPACT,         // fill SMT siblings, then cores, then sockets
+   PLACEMENT_SCATTER,         // round-robin over sockets, then cores, then siblings
+   PLACEMENT_PHYSICAL_CORES,  // one hardware thread per core, compact order
+   PLACEMENT_EXPLICIT         // cpus[i % ncpus] for worker i
+} PlacementPolicy;
+
+typedef struct {
+   PlacementPolicy policy;
+   const int* cpus;
+   int ncpus;
+} PlacementConfig;
+
+// Fills out[nworkers] with a CPU per worker, or -1 everywhere for
+// PLACEMENT_NONE. Returns -1 if the policy cannot be satisfied (empty
+// explicit list, or a CPU outside the allowed set).
+int affinity_plan(const PlacementConfig* config, int nworkers, int* out);
+// Pins the calling thread; returns 0 on success.
+int affinity_pin_self(int cpu);
+
+#endif
@@ -0,0 +1,71 @@
+#include "arena.h"
+#include <stdlib.h>
+
+
+static ArenaBlock* arena_block_new(TaskArena* arena, size_t size) {
+   ArenaBlock* block = aligned_alloc(64, (sizeof(ArenaBlock) + size + 63) & ~(size_t)63);
+   block->next = NULL;
+   block->size = size;
+   atomic_init(&block->used, 0);
+   arena->system_allocs++;
+   return block;
+}
+
+
+void task_arena_init(TaskArena* arena, size_t block_size) {
+   arena->block_size = block_size > 0 ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+   arena->system_allocs = 0;
+   pthread_mutex_init(&arena->grow_lock, NULL);
+   arena->head = arena_block_new(arena, arena->block_size);
+   atomic_init(&arena->current, arena->head);
+}
+
+
+void task_arena_destroy(TaskArena* arena) {
+   ArenaBlock* block = arena->head;
+   while (block) {
+       ArenaBlock* next = block->next;
+       free(block);
+       block = next;
+   }
+   arena->head = NULL;
+   pthread_mutex_destroy(&arena->grow_lock);
+}
+
+
+// Moves past an exhausted block, reusing one kept from an earlier epoch when
+// it is large enough, otherwise linking a new one in after the current block.
+static void arena_advance(TaskArena* arena, ArenaBlock* exhausted, size_t size) {
+   pthread_mutex_lock(&arena->grow_lock);
+   if (atomic_load_explicit(&arena->current, memory_order_relaxed) == exhausted) {
+       ArenaBlock* next = exhausted->next;
+       if (!next || next->size < size) {
+           ArenaBlock* fresh = arena_block_new(arena, size > arena->block_size ? size : arena->block_size);
+           fresh->next = next;
+           exhausted->next = fresh;
+           next = fresh;
+       }
+       atomic_store_explicit(&arena->current, next, memory_order_release);
+   }
+   pthread_mutex_unlock(&arena->grow_lock);
+}
+
+
+void* task_arena_alloc(TaskArena* arena, size_t size) {
+   size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+  
+   while (1) {
+       ArenaBlock* block = atomic_load_explicit(&arena->current, memory_order_acquire);
+       size_t offset = atomic_fetch_add_explicit(&block->used, size, memory_order_relaxed);
+       if (offset + size <= block->size) return block->data + offset;
+       arena_advance(arena, block, size);
+   }
+}
+
+
+void task_arena_reset(TaskArena* arena) {
+   for (ArenaBlock* block = arena->head; block; block = block->next) {
+       atomic_store_explicit(&block->used, 0, memory_order_relaxed);
+   }
+   atomic_store_explicit(&arena->current, arena->head, memory_order_release);
+}
@@ -0,0 +1,38 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator for task arguments. Any thread may allocate concurrently
+// (one fetch-and-add on the current block); memory is never freed
+// individually but reclaimed all at once by task_arena_reset, which keeps
+// the blocks for the next epoch.
+
+#define ARENA_DEFAULT_BLOCK_SIZE (256 * 1024)
+#define ARENA_ALIGNMENT 16
+
+typedef struct ArenaBlock {
+   struct ArenaBlock* next;
+   size_t size;
+   alignas(64) _Atomic(size_t) used;
+   alignas(ARENA_ALIGNMENT) unsigned char data[];
+} ArenaBlock;
+
+typedef struct {
+   _Atomic(ArenaBlock*) current;
+   ArenaBlock* head;
+   size_t block_size;
+   pthread_mutex_t grow_lock;
+   uint64_t system_allocs;
+} TaskArena;
+
+void task_arena_init(TaskArena* arena, size_t block_size);
+void task_arena_destroy(TaskArena* arena);
+void* task_arena_alloc(TaskArena* arena, size_t size);
+// Not safe against concurrent task_arena_alloc.
+void task_arena_reset(TaskArena* arena);
+
+#endif
@@ -104,9 +104,12 @@ void benchmark_schedule_mode(ScheduleMode mode, int num_threads,
                            int *thread_counts, double *task_latencies, int ntasks) {
    TaskScheduler sched;
    scheduler_init(&sched, num_threads, ntasks, mode);
+   // Only tasks in the shared queue are timed here; the matrix and
+   // reduction workloads use keyed and node queues and run in NUMA_LOCALITY.
    if (strcmp(workload, "mixed") == 0) run_mixed_workload(&sched, ntasks);
-   else if (strcmp(workload, "matrix") == 0) run_matrix_workload(&sched, 50);
-   else if (strcmp(workload, "reduction") == 0) run_reduction_workload(&sched, ntasks);
+   
+   size_t first = 0;
+   int total = (int)task_queue_claim(&sched.queue, &first);
    
    double start = get_time_sec();
    
@@ -115,9 +118,10 @@ void benchmark_schedule_mode(ScheduleMode mode, int num_threads,
        int tid = omp_get_thread_num();
        int executed = 0;
        #pragma omp for schedule(dynamic, 1)
-       for (int i = 0; i < sched.tail; i++) {
+       for (int i = 0; i < total; i++) {
+           Task* task = task_queue_at(&sched.queue, first + i);
            uint64_t t_start = get_time_ns();
-           sched.task_queue[i].func(sched.task_queue[i].arg);
+           task->func(task->arg);
            executed++;
            uint64_t t_end = get_time_ns();
            task_latencies[i] = (t_end - t_start) / 1e6; // ms
@@ -126,6 +130,7 @@ void benchmark_schedule_mode(ScheduleMode mode, int num_threads,
    }
    
    double duration = get_time_sec() - start;
+   task_queue_release(&sched.queue, first, total);
    double throughput = (ntasks) / duration;
    *duration_out = duration;
    *throughput_out = throughput;
@@ -231,12 +236,485 @@ void run_stress_test_comparison() {
     printf(">> Conclusion: Lock-Free is %.2fx faster on fine-grained tasks.\n", duration_lock / duration_lf);
 }
 
-int main() {
+static void noop_task(void* arg) {
+    (void)arg;
+}
+
+// MULTI-PRODUCER SUBMIT: P threads submitting concurrently, either through a
+// caller-side mutex (the old workaround) or straight into the lock-free
+// segmented queue, where each submit is one fetch-and-add on the enqueue
+// position.
+void run_multi_producer_comparison() {
+    printf("\n=== MULTI-PRODUCER SUBMIT (100k tasks) ===\n");
+    printf("Mode,Producers,Duration_sec,Throughput\n");
+
+    int ntasks = 100000;
+    int producer_counts[] = {1, 2, 4, 8, 16};
+
+    for (int p = 0; p < 5; p++) {
+        int P = producer_counts[p];
+
+        for (int locked = 1; locked >= 0; locked--) {
+            TaskScheduler sched;
+            scheduler_init(&sched, P, ntasks, SCHEDULE_STATIC);
+            omp_lock_t lock;
+            omp_init_lock(&lock);
+
+            double start = get_time_sec();
+            #pragma omp parallel num_threads(P)
+            {
+                #pragma omp for schedule(static)
+                for (int i = 0; i < ntasks; i++) {
+                    if (locked) omp_set_lock(&lock);
+                    scheduler_submit(&sched, noop_task, NULL, TASK_LIGHT);
+                    if (locked) omp_unset_lock(&lock);
+                }
+            }
+            double duration = get_time_sec() - start;
+
+            printf("%s,%d,%.5f,%.2f\n", locked ? "MUTEX_SUBMIT" : "LOCK_FREE_SUBMIT",
+                   P, duration, ntasks / duration);
+
+            scheduler_run(&sched);
+            omp_destroy_lock(&lock);
+            scheduler_destroy(&sched);
+        }
+    }
+}
+
+// TIMING OVERHEAD: fine-grained dispatch cost with each task-timing mode.
+void run_timing_overhead_comparison() {
+    printf("\n=== TIMING OVERHEAD (Fine-Grained 100k tasks, %s clock) ===\n",
+           timing_source() == CLOCK_SOURCE_TSC ? "TSC" : "MONOTONIC");
+    printf("Timing,SampleRate,Threads,Duration_sec,Throughput\n");
+
+    const char* names[] = {"EVERY_TASK", "SAMPLED", "CHUNKED"};
+    TimingMode modes[] = {TIMING_EVERY_TASK, TIMING_SAMPLED, TIMING_CHUNKED};
+    int ntasks = 100000;
+    int T = 4;
+
+    for (int m = 0; m < 3; m++) {
+        TaskScheduler sched;
+        scheduler_init(&sched, T, ntasks, SCHEDULE_STATIC);
+        scheduler_set_timing(&sched, modes[m], 64);
+        run_fine_grained_workload(&sched, ntasks);
+
+        double start = get_time_sec();
+        scheduler_run(&sched);
+        scheduler_wait(&sched);
+        double duration = get_time_sec() - start;
+
+        printf("%s,%d,%d,%.5f,%.2f\n", names[m], sched.timing_sample_rate, T, duration, ntasks / duration);
+        scheduler_destroy(&sched);
+    }
+}
+
+static void small_arg_task(void* arg) {
+    volatile int x = *(int*)arg;
+    x++;
+}
+
+static void small_arg_task_free(void* arg) {
+    small_arg_task(arg);
+    free(arg);
+}
+
+// ARG ALLOCATION: per-task malloc/free of the argument (the old workload
+// pattern) against scheduler-owned arena storage released in bulk, and
+// against arguments copied inline into the queue slot.
+void run_arena_comparison() {
+    printf("\n=== ARG ALLOCATION (100k small tasks, 4 threads, 5 batches) ===\n");
+    printf("Allocator,Tasks,SystemAllocs,Duration_sec,Throughput\n");
+
+    int ntasks = 100000;
+    int batches = 5;
+    int T = 4;
+
+    const char* names[] = {"MALLOC", "ARENA", "INLINE"};
+
+    for (int a = 0; a < 3; a++) {
+        TaskScheduler sched;
+        scheduler_init(&sched, T, ntasks, SCHEDULE_STATIC);
+        uint64_t arena_allocs_before = sched.arena.system_allocs;
+        uint64_t mallocs = 0;
+
+        double start = get_time_sec();
+        for (int b = 0; b < batches; b++) {
+            for (int i = 0; i < ntasks; i++) {
+                if (a == 2) {
+                    scheduler_submit_inline(&sched, small_arg_task, &i, sizeof(int), TASK_LIGHT);
+                } else if (a == 1) {
+                    int* arg = scheduler_alloc_arg(&sched, sizeof(int));
+                    *arg = i;
+                    scheduler_submit(&sched, small_arg_task, arg, TASK_LIGHT);
+                } else {
+                    int* arg = malloc(sizeof(int));
+                    *arg = i;
+                    mallocs++;
+                    scheduler_submit(&sched, small_arg_task_free, arg, TASK_LIGHT);
+                }
+            }
+            scheduler_run(&sched);
+            scheduler_wait(&sched);
+        }
+        double duration = get_time_sec() - start;
+
+        uint64_t allocs = a > 0 ? sched.arena.system_allocs - arena_allocs_before : mallocs;
+        printf("%s,%d,%lu,%.5f,%.2f\n", names[a], ntasks * batches, allocs,
+               duration, ntasks * batches / duration);
+        scheduler_destroy(&sched);
+    }
+}
+
+// LPT MAKESPAN: the weight-bucketed heterogeneous engine against true
+// longest-processing-time-first on the mixed workload.
+void run_lpt_comparison() {
+    printf("\n=== LPT MAKESPAN (mixed 1000 tasks) ===\n");
+    printf("Threads,HETEROGENEOUS_sec,LPT_sec,Improvement_pct\n");
+
+    int ntasks = 1000;
+    int thread_counts[] = {2, 4, 8};
+    ScheduleMode modes[] = {SCHEDULE_HETEROGENEOUS, SCHEDULE_LPT};
+
+    for (int t = 0; t < 3; t++) {
+        double makespan[2];
+        for (int m = 0; m < 2; m++) {
+            TaskScheduler sched;
+            scheduler_init(&sched, thread_counts[t], ntasks, modes[m]);
+            run_mixed_workload(&sched, ntasks);
+
+            double start = get_time_sec();
+            scheduler_run(&sched);
+            scheduler_wait(&sched);
+            makespan[m] = get_time_sec() - start;
+            scheduler_destroy(&sched);
+        }
+        printf("%d,%.5f,%.5f,%.2f\n", thread_counts[t], makespan[0], makespan[1],
+               (makespan[0] - makespan[1]) / makespan[0] * 100.0);
+    }
+}
+
+// COST MODEL: LPT on tasks that all carry the same weight label but differ
+// 64x in size. The first epoch orders by the label alone; later epochs use
+// the learned per-size costs.
+void run_cost_model_comparison() {
+    printf("\n=== COST MODEL (variable-size 1000 tasks, LPT, 4 threads) ===\n");
+    printf("Epoch,Makespan_sec,Predicted_1k_us,Predicted_64k_us\n");
+
+    int ntasks = 1000;
+    TaskScheduler sched;
+    scheduler_init(&sched, 4, ntasks, SCHEDULE_LPT);
+
+    for (int epoch = 0; epoch < 3; epoch++) {
+        run_variable_workload(&sched, ntasks);
+        double start = get_time_sec();
+        scheduler_run(&sched);
+        scheduler_wait(&sched);
+        double duration = get_time_sec() - start;
+
+        printf("%d,%.5f,%.2f,%.2f\n", epoch, duration,
+               scheduler_predict_cost_ns(&sched, variable_task, TASK_MEDIUM, 1000) / 1e3,
+               scheduler_predict_cost_ns(&sched, variable_task, TASK_MEDIUM, 64000) / 1e3);
+    }
+    scheduler_destroy(&sched);
+}
+
+// PLACEMENT: run-to-run spread of the mixed workload under each worker
+// placement policy.
+void run_placement_comparison() {
+    printf("\n=== PLACEMENT (mixed 500 tasks, 4 threads, 3 runs) ===\n");
+    printf("Policy,Threads,Mapping,Mean_sec,Spread_pct\n");
+
+    const char* names[] = {"NONE", "COMPACT", "SCATTER", "PHYSICAL_CORES"};
+    PlacementPolicy policies[] = {PLACEMENT_NONE, PLACEMENT_COMPACT, PLACEMENT_SCATTER, PLACEMENT_PHYSICAL_CORES};
+    int ntasks = 500;
+    int T = 4;
+    int runs = 3;
+
+    for (int p = 0; p < 4; p++) {
+        PlacementConfig config = {policies[p], NULL, 0};
+        double sum = 0.0, lo = 1e30, hi = 0.0;
+        char mapping[128] = "";
+
+        for (int r = 0; r < runs; r++) {
+            TaskScheduler sched;
+            scheduler_init_placed(&sched, T, ntasks, SCHEDULE_DYNAMIC, &config);
+            run_mixed_workload(&sched, ntasks);
+
+            double start = get_time_sec();
+            scheduler_run(&sched);
+            scheduler_wait(&sched);
+            double duration = get_time_sec() - start;
+            sum += duration;
+            if (duration < lo) lo = duration;
+            if (duration > hi) hi = duration;
+
+            if (r == 0) {
+                for (int t = 0; t < T; t++) {
+                    size_t len = strlen(mapping);
+                    snprintf(mapping + len, sizeof(mapping) - len, "%s%d", t ? " " : "",
+                             scheduler_worker_cpu(&sched, t));
+                }
+            }
+            scheduler_destroy(&sched);
+        }
+        double mean = sum / runs;
+        printf("%s,%d,%s,%.5f,%.2f\n", names[p], T, mapping, mean, (hi - lo) / mean * 100.0);
+    }
+}
+
+// NUMA LOCALITY: matrix (keyed by row block) and reduction (node-hinted)
+// with first-touch setup under scatter placement; only the compute pass is
+// timed.
+void run_numa_locality_comparison() {
+    printf("\n=== NUMA LOCALITY (scatter placement, 4 threads) ===\n");
+    printf("Workload,Threads,Nodes,Duration_sec,Remote_tasks,Displaced_tasks\n");
+
+    const char* names[] = {"matrix_200", "reduction_4M"};
+    int T = 4;
+    PlacementConfig config = {PLACEMENT_SCATTER, NULL, 0};
+
+    for (int w = 0; w < 2; w++) {
+        TaskScheduler sched;
+        scheduler_init_placed(&sched, T, 1024, SCHEDULE_DYNAMIC, &config);
+        MatrixTask matrices;
+        ReductionTask reduction;
+        if (w == 0) {
+            setup_matrix_workload(&sched, &matrices, 200);
+            run_matrix_workload(&sched, &matrices);
+        } else {
+            setup_reduction_workload(&sched, &reduction, 4 << 20);
+            run_reduction_workload(&sched, &reduction);
+        }
+
+        RuntimeMetrics setup;
+        scheduler_snapshot_metrics(&sched, &setup);
+        double start = get_time_sec();
+        scheduler_run(&sched);
+        scheduler_wait(&sched);
+        double duration = get_time_sec() - start;
+
+        RuntimeMetrics m;
+        scheduler_snapshot_metrics(&sched, &m);
+        printf("%s,%d,%d,%.5f,%lu,%lu\n", names[w], T, sched.num_nodes, duration,
+               m.remote_tasks - setup.remote_tasks, m.displaced_tasks - setup.displaced_tasks);
+        scheduler_destroy(&sched);
+    }
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int is_sorted(const int* data, int n) {
+    for (int i = 1; i < n; i++) {
+        if (data[i - 1] > data[i]) return 0;
+    }
+    return 1;
+}
+
+// NESTED SPAWN: recursive quicksort with spawn/sync against serial qsort on
+// the same input.
+void run_nested_spawn_comparison() {
+    printf("\n=== NESTED SPAWN (quicksort 4M ints) ===\n");
+    printf("Method,Threads,Duration_sec,Sorted\n");
+
+    int n = 4 << 20;
+    int* data = malloc(sizeof(int) * n);
+    unsigned int seed = 12345;
+    for (int i = 0; i < n; i++) data[i] = rand_r(&seed);
+
+    double start = get_time_sec();
+    qsort(data, n, sizeof(int), compare_ints);
+    double duration = get_time_sec() - start;
+    printf("serial_qsort,1,%.5f,%s\n", duration, is_sorted(data, n) ? "yes" : "no");
+
+    int thread_counts[] = {1, 4};
+    for (int k = 0; k < 2; k++) {
+        TaskScheduler sched;
+        scheduler_init(&sched, thread_counts[k], 64, SCHEDULE_DYNAMIC);
+        run_quicksort_workload(&sched, data, n);
+
+        start = get_time_sec();
+        scheduler_run(&sched);
+        scheduler_wait(&sched);
+        duration = get_time_sec() - start;
+        printf("spawn_sync,%d,%.5f,%s\n", thread_counts[k], duration, is_sorted(data, n) ? "yes" : "no");
+        scheduler_destroy(&sched);
+    }
+    free(data);
+}
+
+// PARALLEL FOR: sum of 4M ints, 100 hand-cut chunks against
+// scheduler_parallel_for over successive calls as it learns the body's cost;
+// Splits counts the halves handed to idle workers.
+void run_parallel_for_comparison() {
+    printf("\n=== PARALLEL FOR (reduction 4M ints, 4 threads) ===\n");
+    printf("Method,Call,Grain,Splits,Duration_sec,Correct\n");
+
+    int n = 4 << 20;
+    int* data = malloc(sizeof(int) * n);
+    for (int i = 0; i < n; i++) data[i] = 1;
+    long sum = 0;
+    ReductionTask ctx = {data, 0, 0, &sum};
+
+    TaskScheduler sched;
+    scheduler_init(&sched, 4, 128, SCHEDULE_DYNAMIC);
+
+    int chunk = n / 100;
+    double start = get_time_sec();
+    for (int i = 0; i < n; i += chunk) {
+        ReductionTask task = {data, i, (i + chunk > n) ? n : i + chunk, &sum};
+        scheduler_submit_inline(&sched, reduction_task, &task, sizeof(task), TASK_LIGHT);
+    }
+    scheduler_run(&sched);
+    scheduler_wait(&sched);
+    printf("hand_chunked,1,%d,0,%.5f,%s\n", chunk, get_time_sec() - start, sum == n ? "yes" : "no");
+
+    for (int call = 1; call <= 3; call++) {
+        sum = 0;
+        int grain = scheduler_parallel_for_grain(&sched, reduction_range, n);
+        RuntimeMetrics before, after;
+        scheduler_snapshot_metrics(&sched, &before);
+        start = get_time_sec();
+        scheduler_parallel_for(&sched, 0, n, reduction_range, &ctx);
+        scheduler_wait(&sched);
+        double duration = get_time_sec() - start;
+        scheduler_snapshot_metrics(&sched, &after);
+        printf("parallel_for,%d,%d,%lu,%.5f,%s\n", call, grain, after.range_splits - before.range_splits,
+               duration, sum == n ? "yes" : "no");
+    }
+    scheduler_destroy(&sched);
+    free(data);
+}
+
+// BULK SUBMIT: 1M identical fine-grained tasks submitted one by one against
+// a single scheduler_submit_range call.
+void run_bulk_submit_comparison() {
+    printf("\n=== BULK SUBMIT (1M fine-grained tasks, 4 threads) ===\n");
+    printf("Method,Tasks,Queued,Submit_sec,Run_sec\n");
+
+    const char* names[] = {"per_task", "range"};
+    int ntasks = 1000000;
+
+    for (int m = 0; m < 2; m++) {
+        TaskScheduler sched;
+        scheduler_init(&sched, 4, 1024, SCHEDULE_STATIC);
+
+        double start = get_time_sec();
+        if (m == 0) run_fine_grained_workload(&sched, ntasks);
+        else run_fine_grained_range_workload(&sched, ntasks);
+        double submitted = get_time_sec();
+        size_t queued = task_queue_size(&sched.queue);
+        for (int n = 0; n < sched.num_nodes; n++) queued += task_queue_size(&sched.node_queues[n].queue);
+
+        scheduler_run(&sched);
+        scheduler_wait(&sched);
+        printf("%s,%d,%zu,%.5f,%.5f\n", names[m], ntasks, queued, submitted - start, get_time_sec() - submitted);
+        scheduler_destroy(&sched);
+    }
+}
+
+// EPOCH REUSE: many small batches, re-initialising the scheduler for each
+// against starting a new epoch with scheduler_reset.
+void run_epoch_reuse_comparison() {
+    printf("\n=== EPOCH REUSE (2000 batches of 64 fine-grained tasks, 4 threads) ===\n");
+    printf("Method,Batches,Total_sec,Batches_per_sec\n");
+
+    const char* names[] = {"init_destroy", "reset"};
+    int nbatches = 2000, ntasks = 64;
+
+    for (int m = 0; m < 2; m++) {
+        TaskScheduler sched;
+        if (m == 1) scheduler_init(&sched, 4, ntasks, SCHEDULE_DYNAMIC);
+
+        double start = get_time_sec();
+        for (int b = 0; b < nbatches; b++) {
+            if (m == 0) scheduler_init(&sched, 4, ntasks, SCHEDULE_DYNAMIC);
+            run_fine_grained_workload(&sched, ntasks);
+            scheduler_run(&sched);
+            scheduler_wait(&sched);
+            if (m == 0) scheduler_destroy(&sched);
+            else scheduler_reset(&sched);
+        }
+        double duration = get_time_sec() - start;
+        if (m == 1) scheduler_destroy(&sched);
+        printf("%s,%d,%.5f,%.0f\n", names[m], nbatches, duration, nbatches / duration);
+    }
+}
+
+// PARTITION PROLOGUE: 1M fine-grained tasks through the engines that
+// reorder the batch before running it. Workers wait at the barrier for
+// whatever part of that prologue they do not share.
+void run_partition_prologue_comparison() {
+    printf("\n=== PARTITION PROLOGUE (1M fine-grained tasks, 4 threads) ===\n");
+    printf("Mode,Run,Run_sec,Barrier_ms\n");
+
+    const char* names[] = {"HETEROGENEOUS", "LPT"};
+    ScheduleMode modes[] = {SCHEDULE_HETEROGENEOUS, SCHEDULE_LPT};
+    int ntasks = 1000000;
+
+    for (int m = 0; m < 2; m++) {
+        TaskScheduler sched;
+        scheduler_init(&sched, 4, 1024, modes[m]);
+        for (int run = 1; run <= 2; run++) {
+            run_fine_grained_workload(&sched, ntasks);
+            RuntimeMetrics before, after;
+            scheduler_snapshot_metrics(&sched, &before);
+            double start = get_time_sec();
+            scheduler_run(&sched);
+            scheduler_wait(&sched);
+            double duration = get_time_sec() - start;
+            scheduler_snapshot_metrics(&sched, &after);
+            printf("%s,%d,%.5f,%.2f\n", names[m], run, duration,
+                   (after.barrier_wait_ns - before.barrier_wait_ns) / 1e6);
+        }
+        scheduler_destroy(&sched);
+    }
+}
+
+// TRACE EXPORT: Chrome trace-event timelines of the mixed workload, one per
+// engine, for side-by-side inspection in chrome://tracing or Perfetto.
+void run_trace_export() {
+    printf("\n=== TRACE EXPORT (mixed 1000 tasks, 4 threads) ===\n");
+
+    const char* names[] = {"static", "heterogeneous"};
+    ScheduleMode modes[] = {SCHEDULE_STATIC, SCHEDULE_HETEROGENEOUS};
+
+    for (int m = 0; m < 2; m++) {
+        char path[64];
+        snprintf(path, sizeof(path), "trace_%s.json", names[m]);
+
+        TaskScheduler sched;
+        scheduler_init(&sched, 4, 1000, modes[m]);
+        scheduler_enable_trace(&sched, path);
+        run_mixed_workload(&sched, 1000);
+        scheduler_run(&sched);
+        scheduler_wait(&sched);
+        scheduler_destroy(&sched);
+
+        printf("wrote %s\n", path);
+    }
+}
+
+int main(int argc, char** argv) {
+   if (argc > 1 && strcmp(argv[1], "--trace") == 0) {
+       run_trace_export();
+       return 0;
+   }
+
+
    const char* workloads[] = {"mixed"};
    const char* modes[] = {"LOCK_BASED", "STATIC", "DYNAMIC", "GUIDED", "HETEROGENEOUS"};
    ScheduleMode mode_vals[] = {SCHEDULE_STATIC, SCHEDULE_DYNAMIC, SCHEDULE_GUIDED, SCHEDULE_HETEROGENEOUS};
-   int thread_counts_list[] = {1, 2, 4, 8, 12, 16};
-   int num_tcs = 6, ntasks = 1000;
+   // Thread counts double up to the online hardware threads, which are
+   // also included when not a power of two.
+   int max_threads = topology_get()->ncpus;
+   int thread_counts_list[MAX_THREADS];
+   int num_tcs = 0, ntasks = 1000;
+   for (int T = 1; T < max_threads && num_tcs < MAX_THREADS - 1; T *= 2) thread_counts_list[num_tcs++] = T;
+   thread_counts_list[num_tcs++] = max_threads;
 
    double durations[5][MAX_THREADS] = {{0}};
    double throughputs[5][MAX_THREADS] = {{0}};
@@ -255,7 +733,8 @@ int main() {
    for (int t = 0; t < num_tcs; t++) {
        int T = thread_counts_list[t];
 
-       int lock_thread_counts[MAX_THREADS] = {0};
+       int lock_thread_counts[max_threads];
+       memset(lock_thread_counts, 0, sizeof(lock_thread_counts));
        double lock_latencies[MAX_TASKS] = {0.0};
        double lock_duration = benchmark_lock_based(T, ntasks, lock_thread_counts, lock_latencies);
        double lock_throughput = ntasks / lock_duration;
@@ -272,7 +751,8 @@ int main() {
        fairness_ratio[0][t] = fairness;
 
        for (int m = 0; m < 4; m++) {
-           int thread_stats[MAX_THREADS] = {0};
+           int thread_stats[max_threads];
+           memset(thread_stats, 0, sizeof(thread_stats));
            double latency_stats[MAX_TASKS] = {0.0};
            double duration, throughput;
            
@@ -316,7 +796,7 @@ int main() {
    print_histogram_header();
    
    {
-       int lock_thread_counts[MAX_THREADS] = {0};
+       int lock_thread_counts[1] = {0};
        double lock_latencies[MAX_TASKS] = {0.0};
        benchmark_lock_based(1, ntasks, lock_thread_counts, lock_latencies);
        print_latency_histogram(lock_latencies, ntasks);
@@ -324,6 +804,42 @@ int main() {
 
    printf("=== STRESS_TEST ===\n");
    run_stress_test_comparison();
+
+   printf("=== MULTI_PRODUCER ===\n");
+   run_multi_producer_comparison();
+
+   printf("=== TIMING_OVERHEAD ===\n");
+   run_timing_overhead_comparison();
+
+   printf("=== ARG_ALLOCATION ===\n");
+   run_arena_comparison();
+
+   printf("=== LPT_MAKESPAN ===\n");
+   run_lpt_comparison();
+
+   printf("=== COST_MODEL ===\n");
+   run_cost_model_comparison();
+
+   printf("=== PLACEMENT ===\n");
+   run_placement_comparison();
+
+   printf("=== NUMA_LOCALITY ===\n");
+   run_numa_locality_comparison();
+
+   printf("=== NESTED_SPAWN ===\n");
+   run_nested_spawn_comparison();
+
+   printf("=== PARALLEL_FOR ===\n");
+   run_parallel_for_comparison();
+
+   printf("=== BULK_SUBMIT ===\n");
+   run_bulk_submit_comparison();
+   
+   printf("=== EPOCH_REUSE ===\n");
+   run_epoch_reuse_comparison();
+   
+   printf("=== PARTITION_PROLOGUE ===\n");
+   run_partition_prologue_comparison();
    
    return 0;
 }
@@ -0,0 +1,86 @@
+#include "cost_model.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Used until a weight class has been measured at all.
+static const uint64_t weight_prior_ns[] = {0, 1000, 10000, 100000};
+
+
+void cost_model_init(CostModel* model, int nworkers) {
+   model->entries = calloc(COST_MODEL_SLOTS, sizeof(CostEntry));
+   model->locals = aligned_alloc(64, sizeof(CostLocal) * nworkers);
+   memset(model->locals, 0, sizeof(CostLocal) * nworkers);
+   model->nlocals = nworkers;
+   memset(model->weight_ewma_ns, 0, sizeof(model->weight_ewma_ns));
+   memset(model->weight_samples, 0, sizeof(model->weight_samples));
+}
+
+
+void cost_model_destroy(CostModel* model) {
+   free(model->entries);
+   free(model->locals);
+   model->entries = NULL;
+   model->locals = NULL;
+}
+
+
+static void ewma_merge(uint64_t* ewma, uint64_t* samples, uint64_t sum_ns, uint64_t count) {
+   double mean = (double)sum_ns / count;
+   if (*samples == 0) {
+       *ewma = (uint64_t)mean;
+   } else {
+       double w = (double)count / (count + COST_MODEL_MEMORY);
+       *ewma = (uint64_t)(*ewma + (mean - *ewma) * w);
+   }
+   *samples += count;
+}
+
+
+static CostEntry* cost_model_find(const CostModel* model, uintptr_t key, bool insert) {
+   size_t h = cost_model_hash(key, COST_MODEL_SLOTS);
+   for (int probe = 0; probe < COST_MODEL_SLOTS; probe++) {
+       CostEntry* e = &model->entries[(h + probe) & (COST_MODEL_SLOTS - 1)];
+       if (e->key == key) return e;
+       if (e->key == 0) {
+           if (!insert) return NULL;
+           e->key = key;
+           return e;
+       }
+   }
+   return NULL;
+}
+
+
+void cost_model_fold(CostModel* model) {
+   for (int w = 0; w < model->nlocals; w++) {
+       CostSample* slots = model->locals[w].slots;
+       for (int i = 0; i < COST_LOCAL_SLOTS; i++) {
+           CostSample* s = &slots[i];
+           if (s->count == 0) continue;
+          
+           CostEntry* e = cost_model_find(model, s->key, true);
+           if (e) ewma_merge(&e->ewma_ns, &e->samples, s->sum_ns, s->count);
+           if (s->weight < 4) {
+               ewma_merge(&model->weight_ewma_ns[s->weight], &model->weight_samples[s->weight],
+                          s->sum_ns, s->count);
+           }
+           memset(s, 0, sizeof(*s));
+       }
+   }
+}
+
+
+bool cost_model_lookup(const CostModel* model, uintptr_t key, uint64_t* ns) {
+   CostEntry* e = cost_model_find(model, key, false);
+   if (!e || e->samples == 0) return false;
+   *ns = e->ewma_ns;
+   return true;
+}
+
+
+uint64_t cost_model_predict(const CostModel* model, uintptr_t key, uint8_t weight) {
+   uint64_t ns;
+   if (cost_model_lookup(model, key, &ns)) return ns;
+   if (weight < 4 && model->weight_samples[weight] > 0) return model->weight_ewma_ns[weight];
+   return weight < 4 ? weight_prior_ns[weight] : weight_prior_ns[TASK_MEDIUM];
+}
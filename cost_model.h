@@ -0,0 +1,89 @@
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "task.h"
+
+// Online estimate of task execution time, keyed by task function and a
+// power-of-two class of the submitter's size hint. Workers record timed
+// executions into private sample tables; cost_model_fold merges them into
+// a shared EWMA per key between batches, so predictions are read without
+// any synchronisation while a batch runs. Keys never seen fall back to the
+// learned average of their weight class, then to a fixed prior.
+
+#define COST_MODEL_SLOTS 1024
+#define COST_LOCAL_SLOTS 64
+// A batch mean over n samples moves the estimate by n / (n + MEMORY).
+#define COST_MODEL_MEMORY 16
+// Samples recorded with this weight train their own key only.
+#define COST_WEIGHT_NONE 0xff
+
+typedef struct {
+   uintptr_t key;
+   uint64_t ewma_ns;
+   uint64_t samples;
+} CostEntry;
+
+typedef struct {
+   uintptr_t key;
+   uint64_t sum_ns;
+   uint32_t count;
+   uint8_t weight;
+} CostSample;
+
+typedef struct {
+   alignas(64) CostSample slots[COST_LOCAL_SLOTS];
+} CostLocal;
+
+typedef struct {
+   CostEntry* entries;
+   CostLocal* locals;
+   int nlocals;
+   uint64_t weight_ewma_ns[4];
+   uint64_t weight_samples[4];
+} CostModel;
+
+// 0 for no hint, otherwise 1 + floor(log2(hint)).
+static inline uint8_t cost_size_class(size_t hint) {
+   return hint ? (uint8_t)(64 - __builtin_clzll((unsigned long long)hint)) : 0;
+}
+
+// User-space code addresses leave the top byte free for the size class.
+static inline uintptr_t cost_model_key(void (*func)(void*), uint8_t size_class) {
+   return (uintptr_t)func | ((uintptr_t)size_class << 56);
+}
+
+static inline size_t cost_model_hash(uintptr_t key, size_t slots) {
+   return (size_t)((key * 0x9e3779b97f4a7c15ull) >> 32) & (slots - 1);
+}
+
+void cost_model_init(CostModel* model, int nworkers);
+void cost_model_destroy(CostModel* model);
+
+// Owner worker only. A sample is dropped if the local table is full.
+static inline void cost_model_record(CostModel* model, int worker, uintptr_t key, uint8_t weight,
+                                     uint64_t ns) {
+   CostSample* slots = model->locals[worker].slots;
+   size_t h = cost_model_hash(key, COST_LOCAL_SLOTS);
+   for (int probe = 0; probe < COST_LOCAL_SLOTS; probe++) {
+       CostSample* s = &slots[(h + probe) & (COST_LOCAL_SLOTS - 1)];
+       if (s->key == key || s->key == 0) {
+           s->key = key;
+           s->sum_ns += ns;
+           s->count++;
+           s->weight = weight;
+           return;
+       }
+   }
+}
+
+// Must not run concurrently with record or predict.
+void cost_model_fold(CostModel* model);
+
+// True if key itself has been measured.
+bool cost_model_lookup(const CostModel* model, uintptr_t key, uint64_t* ns);
+uint64_t cost_model_predict(const CostModel* model, uintptr_t key, uint8_t weight);
+
+#endif
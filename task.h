@@ -0,0 +1,25 @@
+#ifndef TASK_H
+#define TASK_H
+#include <stdalign.h>
+#include <stdint.h>
+
+typedef enum {
+   TASK_LIGHT = 1,
+   TASK_MEDIUM = 2,
+   TASK_HEAVY = 3
+} TaskWeight;
+
+// Arguments up to this size can be copied into the task itself; together
+// with the queue's sequence word a slot then fills exactly one cache line.
+#define TASK_INLINE_ARG_SIZE 32
+
+typedef struct {
+   void (*func)(void*);
+   void* arg;
+   int id;
+   uint8_t weight;      // TaskWeight
+   uint8_t size_class;  // cost_size_class of the submitter's size hint
+   alignas(8) unsigned char inline_arg[TASK_INLINE_ARG_SIZE];
+} Task;
+
+#endif
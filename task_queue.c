@@ -0,0 +1,218 @@
+#include "task_queue.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static void segment_reset(TaskSegment* seg, size_t index) {
+   atomic_init(&seg->next, NULL);
+   seg->index = index;
+   for (size_t i = 0; i < TASK_SEGMENT_SIZE; i++) {
+       atomic_init(&seg->slots[i].sequence, 0);
+   }
+}
+
+
+static TaskSegment* segment_new(size_t index) {
+   TaskSegment* seg = aligned_alloc(64, sizeof(TaskSegment));
+   segment_reset(seg, index);
+   return seg;
+}
+
+
+void task_queue_init(TaskQueue* q, size_t capacity) {
+   size_t nsegs = (capacity + TASK_SEGMENT_SIZE - 1) >> TASK_SEGMENT_SHIFT;
+   if (nsegs < 1) nsegs = 1;
+  
+   q->head = segment_new(0);
+   TaskSegment* last = q->head;
+   for (size_t i = 1; i < nsegs; i++) {
+       TaskSegment* seg = segment_new(i);
+       atomic_init(&last->next, seg);
+       last = seg;
+   }
+  
+   atomic_init(&q->enqueue_pos, 0);
+   atomic_init(&q->producers, 0);
+   atomic_init(&q->tail, q->head);
+   atomic_init(&q->dequeue_pos, 0);
+   q->retired = NULL;
+   q->reserve_segments = nsegs;
+   q->dir_capacity = 16;
+   q->dir = malloc(sizeof(TaskSegment*) * q->dir_capacity);
+   q->dir_base = 0;
+}
+
+
+void task_queue_destroy(TaskQueue* q) {
+   TaskSegment* lists[2] = {q->head, q->retired};
+   for (int l = 0; l < 2; l++) {
+       TaskSegment* seg = lists[l];
+       while (seg) {
+           TaskSegment* next = atomic_load_explicit(&seg->next, memory_order_relaxed);
+           free(seg);
+           seg = next;
+       }
+   }
+   free(q->dir);
+   q->head = NULL;
+   q->retired = NULL;
+   q->dir = NULL;
+}
+
+
+// Enqueued tasks not yet claimed by the consumer, published or not.
+size_t task_queue_size(TaskQueue* q) {
+   size_t enq = atomic_load_explicit(&q->enqueue_pos, memory_order_acquire);
+   size_t deq = atomic_load_explicit(&q->dequeue_pos, memory_order_acquire);
+   return enq - deq;
+}
+
+
+// The producer count is raised before the tail is read, so a segment the
+// consumer has unlinked can only still be referenced while it is non-zero.
+static TaskSlot* task_queue_reserve(TaskQueue* q, size_t* out_pos) {
+   atomic_fetch_add(&q->producers, 1);
+   TaskSegment* seg = atomic_load(&q->tail);
+   size_t pos = atomic_fetch_add_explicit(&q->enqueue_pos, 1, memory_order_relaxed);
+   size_t index = pos >> TASK_SEGMENT_SHIFT;
+  
+   while (seg->index < index) {
+       TaskSegment* next = atomic_load_explicit(&seg->next, memory_order_acquire);
+       if (!next) {
+           TaskSegment* fresh = segment_new(seg->index + 1);
+           if (atomic_compare_exchange_strong_explicit(&seg->next, &next, fresh,
+                                                       memory_order_acq_rel, memory_order_acquire)) {
+               next = fresh;
+           } else {
+               free(fresh);
+           }
+       }
+       TaskSegment* expected = seg;
+       atomic_compare_exchange_strong(&q->tail, &expected, next);
+       seg = next;
+   }
+  
+   *out_pos = pos;
+   return &seg->slots[pos & TASK_SEGMENT_MASK];
+}
+
+
+static void task_queue_publish(TaskQueue* q, TaskSlot* slot, size_t pos) {
+   atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+   atomic_fetch_sub_explicit(&q->producers, 1, memory_order_release);
+}
+
+
+void task_queue_enqueue(TaskQueue* q, void (*func)(void*), void* arg, TaskWeight weight, uint8_t size_class,
+                        int id) {
+   size_t pos;
+   TaskSlot* slot = task_queue_reserve(q, &pos);
+  
+   slot->task.func = func;
+   slot->task.arg = arg;
+   slot->task.weight = weight;
+   slot->task.size_class = size_class;
+   slot->task.id = id;
+   task_queue_publish(q, slot, pos);
+}
+
+
+void task_queue_enqueue_inline(TaskQueue* q, void (*func)(void*), const void* arg, size_t size,
+                               TaskWeight weight, uint8_t size_class, int id) {
+   size_t pos;
+   TaskSlot* slot = task_queue_reserve(q, &pos);
+
+   memcpy(slot->task.inline_arg, arg, size);
+   slot->task.func = func;
+   slot->task.arg = slot->task.inline_arg;
+   slot->task.weight = weight;
+   slot->task.size_class = size_class;
+   slot->task.id = id;
+   task_queue_publish(q, slot, pos);
+}
+
+
+size_t task_queue_claim(TaskQueue* q, size_t* first) {
+   size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+   TaskSegment* seg = q->head;
+   while (seg->index < (pos >> TASK_SEGMENT_SHIFT)) {
+       seg = atomic_load_explicit(&seg->next, memory_order_acquire);
+       if (!seg) return 0;
+   }
+  
+   // Only a contiguous run of published slots can be claimed; a producer
+   // that has reserved a slot but not yet filled it ends the batch.
+   q->dir_base = seg->index;
+   q->dir[0] = seg;
+   size_t nsegs = 1;
+   size_t end = pos;
+   while (1) {
+       if ((end >> TASK_SEGMENT_SHIFT) != seg->index) {
+           TaskSegment* next = atomic_load_explicit(&seg->next, memory_order_acquire);
+           if (!next) break;
+           seg = next;
+           if (nsegs == q->dir_capacity) {
+               q->dir_capacity *= 2;
+               q->dir = realloc(q->dir, sizeof(TaskSegment*) * q->dir_capacity);
+           }
+           q->dir[nsegs++] = seg;
+       }
+       size_t seq = atomic_load_explicit(&seg->slots[end & TASK_SEGMENT_MASK].sequence, memory_order_acquire);
+       if (seq != end + 1) break;
+       end++;
+   }
+   if (end == pos) return 0;
+  
+   atomic_store_explicit(&q->dequeue_pos, end, memory_order_release);
+   *first = pos;
+   return end - pos;
+}
+
+
+// Appends a quiescent segment after the last linked one, racing producers
+// that link fresh segments there too. Beyond the reserve it is freed.
+static void task_queue_recycle(TaskQueue* q, TaskSegment* seg) {
+   TaskSegment* last = atomic_load(&q->tail);
+   while (1) {
+       TaskSegment* next = atomic_load_explicit(&last->next, memory_order_acquire);
+       if (next) {
+           last = next;
+           continue;
+       }
+       size_t in_use = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed) >> TASK_SEGMENT_SHIFT;
+       if ((intptr_t)(last->index - in_use) >= (intptr_t)q->reserve_segments) {
+           free(seg);
+           return;
+       }
+       segment_reset(seg, last->index + 1);
+       if (atomic_compare_exchange_strong_explicit(&last->next, &next, seg,
+                                                   memory_order_release, memory_order_acquire)) {
+           return;
+       }
+   }
+}
+
+
+void task_queue_release(TaskQueue* q, size_t first, size_t count) {
+   size_t released = first + count;
+  
+   // A segment is done once every position in it is released. The tail is
+   // never unlinked: producers may still be starting from it.
+   while ((q->head->index + 1) << TASK_SEGMENT_SHIFT <= released) {
+       TaskSegment* seg = q->head;
+       TaskSegment* next = atomic_load_explicit(&seg->next, memory_order_acquire);
+       if (!next || seg == atomic_load(&q->tail)) break;
+       q->head = next;
+       atomic_store_explicit(&seg->next, q->retired, memory_order_relaxed);
+       q->retired = seg;
+   }
+  
+   if (q->retired && atomic_load(&q->producers) == 0) {
+       while (q->retired) {
+           TaskSegment* seg = q->retired;
+           q->retired = atomic_load_explicit(&seg->next, memory_order_relaxed);
+           task_queue_recycle(q, seg);
+       }
+   }
+}
@@ -0,0 +1,75 @@
+#ifndef TASK_QUEUE_H
+#define TASK_QUEUE_H
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "task.h"
+
+// Unbounded lock-free task queue made of linked fixed-size segments.
+// Producers take a position with one fetch-and-add and link a new segment
+// when theirs does not exist yet; tasks are never moved once written. A
+// slot is published by storing pos + 1 in its sequence word.
+//
+// There is a single consumer, which claims published tasks in batches and
+// releases them in claim order. Fully released segments are unlinked and,
+// once no producer is inside an enqueue, recycled at the end of the chain
+// (up to the reserve given at init) or freed.
+
+#define TASK_SEGMENT_SHIFT 10
+#define TASK_SEGMENT_SIZE ((size_t)1 << TASK_SEGMENT_SHIFT)
+#define TASK_SEGMENT_MASK (TASK_SEGMENT_SIZE - 1)
+
+typedef struct {
+   alignas(64) _Atomic(size_t) sequence;
+   Task task;
+} TaskSlot;
+
+typedef struct TaskSegment {
+   _Atomic(struct TaskSegment*) next;
+   size_t index;
+   alignas(64) TaskSlot slots[TASK_SEGMENT_SIZE];
+} TaskSegment;
+
+typedef struct {
+   alignas(64) _Atomic(size_t) enqueue_pos;
+   _Atomic(size_t) producers;
+   _Atomic(TaskSegment*) tail;
+
+   // Consumer side.
+   alignas(64) _Atomic(size_t) dequeue_pos;
+   TaskSegment* head;
+   TaskSegment* retired;
+   size_t reserve_segments;
+   TaskSegment** dir;
+   size_t dir_base;
+   size_t dir_capacity;
+} TaskQueue;
+
+// capacity is only a hint: enough segments for it are linked up front and
+// kept for reuse.
+void task_queue_init(TaskQueue* q, size_t capacity);
+void task_queue_destroy(TaskQueue* q);
+size_t task_queue_size(TaskQueue* q);
+
+// id is stored in the task as given.
+void task_queue_enqueue(TaskQueue* q, void (*func)(void*), void* arg, TaskWeight weight, uint8_t size_class,
+                        int id);
+// Copies size bytes (at most TASK_INLINE_ARG_SIZE) into the slot; the task
+// receives a pointer to that copy, valid until its slot is released.
+void task_queue_enqueue_inline(TaskQueue* q, void (*func)(void*), const void* arg, size_t size,
+                               TaskWeight weight, uint8_t size_class, int id);
+
+// Consumer only: claim every published task at the head as one contiguous
+// range, index into it, then release it before claiming again.
+size_t task_queue_claim(TaskQueue* q, size_t* first);
+void task_queue_release(TaskQueue* q, size_t first, size_t count);
+
+// Valid for positions of the current claim.
+static inline Task* task_queue_at(TaskQueue* q, size_t pos) {
+   TaskSegment* seg = q->dir[(pos >> TASK_SEGMENT_SHIFT) - q->dir_base];
+   return &seg->slots[pos & TASK_SEGMENT_MASK].task;
+}
+
+#endif
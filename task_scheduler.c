@@ -1,221 +1,1694 @@
 #include "task_scheduler.h"
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
+#include <math.h>
+#include <sched.h>
 
 
-static uint64_t get_time_ns() {
-   struct timespec ts;
-   clock_gettime(CLOCK_MONOTONIC, &ts);
-   return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
-}
+static void* pool_main(void* arg);
 
 
 void scheduler_init(TaskScheduler* sched, int num_threads, int capacity, ScheduleMode mode) {
-   sched->task_queue = malloc(sizeof(Task) * capacity);
+   scheduler_init_placed(sched, num_threads, capacity, mode, NULL);
+}
+
+
+int scheduler_init_placed(TaskScheduler* sched, int num_threads, int capacity, ScheduleMode mode,
+                          const PlacementConfig* placement) {
+   task_queue_init(&sched->queue, capacity);
    sched->capacity = capacity;
-   sched->head = 0;
-   sched->tail = 0;
-   sched->active_tasks = 0;
+   sched->batch_base = 0;
+   atomic_init(&sched->active_tasks, 0);
+   atomic_init(&sched->next_task_id, 0);
    sched->num_threads = num_threads;
    sched->mode = mode;
    sched->running = false;
+   sched->variance_threshold = ADAPTIVE_DEFAULT_VARIANCE_THRESHOLD;
+   sched->adaptive_mode = SCHEDULE_DYNAMIC;
 
    sched->metrics.tasks_completed = 0;
    sched->metrics.total_exec_time_ns = 0;
    sched->metrics.idle_time_ns = 0;
+   sched->metrics.barrier_wait_ns = 0;
+   sched->metrics.work_search_ns = 0;
+   sched->metrics.avg_exec_time_ms = 0.0;
+   sched->metrics.idle_ratio = 0.0;
    sched->metrics.queue_accesses = 0;
+   sched->metrics.steal_attempts = 0;
+   sched->metrics.steals = 0;
+   sched->metrics.remote_tasks = 0;
+   sched->metrics.displaced_tasks = 0;
+   sched->metrics.range_splits = 0;
+
+   sched->worker_stats = aligned_alloc(64, sizeof(WorkerStats) * num_threads);
+   memset(sched->worker_stats, 0, sizeof(WorkerStats) * num_threads);
+   sched->lpt_cursors = aligned_alloc(64, sizeof(LptCursor) * num_threads);
+   sched->lpt_bounds = malloc(sizeof(int) * (num_threads + 1));
+   sched->prologue_sums = malloc(sizeof(double) * num_threads);
+   sched->prologue_counts = malloc(sizeof(int) * num_threads * (num_threads > 2 ? num_threads : 2));
+   sched->batch_costs = NULL;
+   sched->batch_order = NULL;
+   sched->batch_sorted = NULL;
+   sched->batch_aux = NULL;
+   sched->batch_scratch_capacity = 0;
+   cost_model_init(&sched->cost_model, num_threads);
+   sched->timing_mode = TIMING_EVERY_TASK;
+   sched->timing_sample_rate = 1;
+   timing_init(CLOCK_SOURCE_AUTO);
+   sched->trace = NULL;
+   sched->trace_path = NULL;
+   task_arena_init(&sched->arena, ARENA_DEFAULT_BLOCK_SIZE);
+
+   sched->worker_queues = aligned_alloc(64, sizeof(LocalQueue) * num_threads);
+   for (int t = 0; t < num_threads; t++) {
+       task_queue_init(&sched->worker_queues[t].queue, 0);
+       sched->worker_queues[t].batch_count = 0;
+       atomic_init(&sched->worker_queues[t].next, 0);
+   }
+  
+   sched->deques = aligned_alloc(64, sizeof(WSDeque) * num_threads);
+   sched->ready = aligned_alloc(64, sizeof(WSDeque) * num_threads);
+   for (int i = 0; i < num_threads; i++) {
+       ws_deque_init(&sched->deques[i], capacity / num_threads + 1);
+       ws_deque_init(&sched->ready[i], 64);
+   }
+   atomic_init(&sched->ready_inflight, 0);
+   atomic_init(&sched->idle_workers, 0);
+   atomic_init(&sched->dag_nodes, NULL);
   
    omp_set_num_threads(num_threads);
+  
+   pthread_mutex_init(&sched->pool_lock, NULL);
+   pthread_cond_init(&sched->work_cv, NULL);
+   pthread_cond_init(&sched->done_cv, NULL);
+   sched->run_requests = 0;
+   sched->runs_served = 0;
+   sched->run_since_wait = false;
+   atomic_init(&sched->sync_waiters, 0);
+   sched->shutdown = false;
+   sched->pool_exit = false;
+   sched->batch_count = 0;
+  
+   sched->topology = topology_get();
+   sched->num_nodes = sched->topology->ndomains[TOPO_NODE];
+   sched->node_queues = aligned_alloc(64, sizeof(LocalQueue) * sched->num_nodes);
+   for (int n = 0; n < sched->num_nodes; n++) {
+       task_queue_init(&sched->node_queues[n].queue, 0);
+       sched->node_queues[n].batch_count = 0;
+       atomic_init(&sched->node_queues[n].next, 0);
+   }
+   sched->local_batch_count = 0;
+   sched->worker_cpus = malloc(sizeof(int) * num_threads);
+   int placed = affinity_plan(placement, num_threads, sched->worker_cpus);
+   if (placed != 0) affinity_plan(NULL, num_threads, sched->worker_cpus);
+   sched->pool_ready = false;
+   pthread_create(&sched->pool_thread, NULL, pool_main, sched);
+  
+   // Workers pin themselves on startup; wait so the mapping can be reported.
+   pthread_mutex_lock(&sched->pool_lock);
+   while (!sched->pool_ready) {
+       pthread_cond_wait(&sched->done_cv, &sched->pool_lock);
+   }
+   pthread_mutex_unlock(&sched->pool_lock);
+  
+   for (int t = 0; t < num_threads && placed == 0; t++) {
+       if (placement && placement->policy != PLACEMENT_NONE && sched->worker_cpus[t] < 0) placed = -1;
+   }
+   return placed;
+}
+
+
+int scheduler_worker_cpu(TaskScheduler* sched, int tid) {
+   return sched->worker_cpus[tid];
+}
+
+
+int scheduler_worker_node(TaskScheduler* sched, int tid) {
+   return topology_domain(sched->topology, sched->worker_cpus[tid], TOPO_NODE);
+}
+
+
+bool scheduler_workers_share(TaskScheduler* sched, int tid_a, int tid_b, TopoLevel level) {
+   return topology_shares(sched->topology, sched->worker_cpus[tid_a], sched->worker_cpus[tid_b], level);
+}
+
+
+// Same split as execute_task_static.
+int scheduler_home_node(TaskScheduler* sched, int index, int count) {
+   if (count <= 0) return -1;
+   int chunk = (count + sched->num_threads - 1) / sched->num_threads;
+   return scheduler_worker_node(sched, index / chunk);
+}
+
+
+// scheduler_wait holds active_tasks this far below zero while it resets the
+// argument arena.
+#define ARENA_RESET_HOLD (INT_MIN / 2)
+
+// Counts a task in flight before its submitter allocates from the arena or
+// enqueues it, so the arena is never reset under a submission. One that
+// lands during a reset waits for the reset to finish.
+static inline void count_submission(TaskScheduler* sched) {
+   if (atomic_fetch_add_explicit(&sched->active_tasks, 1, memory_order_acquire) < 0) {
+       while (atomic_load_explicit(&sched->active_tasks, memory_order_acquire) < 0) {
+           sched_yield();
+       }
+   }
+}
+
+
+// A task's place in the epoch's submission order, whichever queue or deque
+// it travels through; traces show it as the task id.
+static inline int next_task_id(TaskScheduler* sched) {
+   return atomic_fetch_add_explicit(&sched->next_task_id, 1, memory_order_relaxed);
+}
+
+
+bool scheduler_submit(TaskScheduler* sched, void (*func)(void*), void* arg, TaskWeight weight) {
+   return scheduler_submit_sized(sched, func, arg, weight, 0);
+}
+
+
+bool scheduler_submit_sized(TaskScheduler* sched, void (*func)(void*), void* arg, TaskWeight weight,
+                            size_t size_hint) {
+   count_submission(sched);
+   task_queue_enqueue(&sched->queue, func, arg, weight, cost_size_class(size_hint), next_task_id(sched));
+   return true;
+}
+
+
+static bool submit_copy(TaskScheduler* sched, TaskQueue* queue, void (*func)(void*), const void* arg,
+                        size_t size, TaskWeight weight) {
+   count_submission(sched);
+   if (size <= TASK_INLINE_ARG_SIZE) {
+       task_queue_enqueue_inline(queue, func, arg, size, weight, 0, next_task_id(sched));
+   } else {
+       void* copy = scheduler_alloc_arg(sched, size);
+       memcpy(copy, arg, size);
+       task_queue_enqueue(queue, func, copy, weight, 0, next_task_id(sched));
+   }
+   return true;
+}
+
+
+bool scheduler_submit_inline(TaskScheduler* sched, void (*func)(void*), const void* arg, size_t size,
+                             TaskWeight weight) {
+   return submit_copy(sched, &sched->queue, func, arg, size, weight);
+}
+
+
+bool scheduler_submit_on_node(TaskScheduler* sched, void (*func)(void*), const void* arg, size_t size,
+                              TaskWeight weight, int node) {
+   TaskQueue* queue = &sched->queue;
+   if (node >= 0 && node < sched->num_nodes) queue = &sched->node_queues[node].queue;
+   return submit_copy(sched, queue, func, arg, size, weight);
+}
+
+
+int scheduler_key_worker(TaskScheduler* sched, uint64_t key) {
+   return (int)(key % (uint64_t)sched->num_threads);
 }
 
 
-void scheduler_submit(TaskScheduler* sched, void (*func)(void*), void* arg, TaskWeight weight) {
-   int tail = sched->tail;
-   sched->task_queue[tail % sched->capacity].func = func;
-   sched->task_queue[tail % sched->capacity].arg = arg;
-   sched->task_queue[tail % sched->capacity].weight = weight;
-   sched->task_queue[tail % sched->capacity].id = tail;
-   sched->tail++;
-   sched->active_tasks++;
+bool scheduler_submit_keyed(TaskScheduler* sched, void (*func)(void*), const void* arg, size_t size,
+                            TaskWeight weight, uint64_t key) {
+   TaskQueue* queue = &sched->worker_queues[scheduler_key_worker(sched, key)].queue;
+   return submit_copy(sched, queue, func, arg, size, weight);
 }
 
 
-static void execute_task_static(TaskScheduler* sched) {
-   int total = sched->tail;
+static inline Task* batch_task(TaskScheduler* sched, int i) {
+   return task_queue_at(&sched->queue, sched->batch_base + i);
+}
+
+
+static uint32_t next_victim(uint32_t* seed) {
+   uint32_t x = *seed;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   *seed = x;
+   return x;
+}
+
+
+// Dependency graph nodes. A node is released once its pending count drops
+// to zero; successors hang off a lock-free list that is closed (swapped for
+// EDGES_CLOSED) when the node completes, so late edges see it as finished.
+
+struct TaskEdge {
+   TaskNode* succ;
+   struct TaskEdge* next;
+};
+
+struct TaskNode {
+   void (*func)(void*);
+   void* arg;
+   Task exec;
+   _Atomic(int) pending;
+   _Atomic(TaskEdge*) successors;
+   TaskScheduler* sched;
+   TaskNode* next_alloc;
+};
+
+#define EDGES_CLOSED ((TaskEdge*)1)
+
+typedef struct {
+   Task exec;
+   void (*func)(void*);
+   void* arg;
+   TaskGroup* group;
+   TaskScheduler* sched;
+} SpawnedTask;
+
+// Identifies the pool worker running on this thread, if any.
+static _Thread_local TaskScheduler* tls_sched = NULL;
+static _Thread_local int tls_tid = 0;
+static _Thread_local bool tls_draining = false;
+
+static void drain_local_ready(TaskScheduler* sched);
+
+
+// Counters are written only by their owning worker, so a relaxed
+// load/store pair is enough and no locked instruction is issued.
+static inline void stat_add(_Atomic(uint64_t)* counter, uint64_t value) {
+   atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+                         memory_order_relaxed);
+}
+
+
+static void dag_node_run(void* arg);
+static void spawned_run(void* arg);
+static void range_task(void* arg);
+
+// Graph nodes and spawned tasks run through wrappers; their cost is the
+// user function's.
+static inline uintptr_t task_cost_key(const Task* task) {
+   void (*func)(void*) = task->func;
+   if (func == dag_node_run) func = ((TaskNode*)task->arg)->func;
+   else if (func == spawned_run) func = ((SpawnedTask*)task->arg)->func;
+   return cost_model_key(func, task->size_class);
+}
+
+
+// A range's duration depends on how much of it ran and how it split, so it
+// must not shift the prior of its weight class; range_task records its
+// per-iteration cost itself.
+static inline uint8_t task_cost_weight(const Task* task) {
+   void (*func)(void*) = task->func;
+   if (func == spawned_run) func = ((SpawnedTask*)task->arg)->func;
+   return func == range_task ? COST_WEIGHT_NONE : task->weight;
+}
+
+
+// Runs one task with its own pair of clock reads; returns the elapsed ticks.
+// The descriptor is read up front: a spawned task's is freed as it finishes.
+static inline uint64_t run_task_timed(TaskScheduler* sched, WorkerStats* stats, Task* task) {
+   uintptr_t key = task_cost_key(task);
+   uint8_t weight = task_cost_weight(task);
+   uint64_t t_start = timing_now();
+   task->func(task->arg);
+   uint64_t elapsed = timing_now() - t_start;
   
-   #pragma omp parallel
-   {
-       int tid = omp_get_thread_num();
-       int nthreads = omp_get_num_threads();
-       int chunk_size = (total + nthreads - 1) / nthreads;
-       int start = tid * chunk_size;
-       int end = (start + chunk_size > total) ? total : start + chunk_size;
-      
-       for (int i = start; i < end; i++) {
-           uint64_t t_start = get_time_ns();
-           sched->task_queue[i].func(sched->task_queue[i].arg);
-           uint64_t t_end = get_time_ns();
-          
-           #pragma omp atomic
-           sched->metrics.total_exec_time_ns += (t_end - t_start);
-          
-           #pragma omp atomic
-           sched->metrics.tasks_completed++;
-          
-           #pragma omp atomic
-           sched->active_tasks--;
+   cost_model_record(&sched->cost_model, tls_tid, key, weight, timing_ticks_to_ns(elapsed));
+   stat_add(&stats->timed_ticks, elapsed);
+   stat_add(&stats->timed_tasks, 1);
+   stat_add(&stats->tasks_completed, 1);
+   return elapsed;
+}
+
+
+static inline uint64_t run_task_traced(TaskScheduler* sched, WorkerStats* stats, Task* task) {
+   uintptr_t key = task_cost_key(task);
+   TaskWeight weight = task->weight;
+   uint8_t cost_weight = task_cost_weight(task);
+   int id = task->id;
+   uint64_t t_start = timing_now();
+   task->func(task->arg);
+   uint64_t t_end = timing_now();
+  
+   cost_model_record(&sched->cost_model, tls_tid, key, cost_weight, timing_ticks_to_ns(t_end - t_start));
+   stat_add(&stats->timed_ticks, t_end - t_start);
+   stat_add(&stats->timed_tasks, 1);
+   stat_add(&stats->tasks_completed, 1);
+   trace_record(&sched->trace[tls_tid], id, weight, t_start, t_end);
+   return t_end - t_start;
+}
+
+
+// Runs one task, then any ready tasks it left on this worker's deque.
+// Returns the ticks the task itself took if it was timed, else 0; measure
+// times it whatever the timing mode.
+static inline uint64_t run_task_measured(TaskScheduler* sched, Task* task, bool measure) {
+   WorkerStats* stats = &sched->worker_stats[tls_tid];
+   uint64_t elapsed = 0;
+  
+   // Tracing needs both timestamps of every task, whatever the timing mode.
+   if (sched->trace) {
+       elapsed = run_task_traced(sched, stats, task);
+   } else if (measure) {
+       elapsed = run_task_timed(sched, stats, task);
+       // Keep the task out of the current chunk's span as well.
+       if (sched->timing_mode == TIMING_CHUNKED && stats->chunk_open) stats->chunk_start += elapsed;
+   } else switch (sched->timing_mode) {
+       case TIMING_EVERY_TASK:
+           elapsed = run_task_timed(sched, stats, task);
+           break;
+       case TIMING_SAMPLED:
+           if (--stats->sample_countdown <= 0) {
+               stats->sample_countdown = sched->timing_sample_rate;
+               elapsed = run_task_timed(sched, stats, task);
+           } else {
+               task->func(task->arg);
+               stat_add(&stats->tasks_completed, 1);
+           }
+           break;
+       case TIMING_CHUNKED:
+           if (!stats->chunk_open) {
+               stats->chunk_open = true;
+               stats->chunk_start = timing_now();
+               stats->sample_countdown = sched->timing_sample_rate;
+           }
+           task->func(task->arg);
+           stat_add(&stats->tasks_completed, 1);
+           if (--stats->sample_countdown <= 0) {
+               uint64_t now = timing_now();
+               stat_add(&stats->timed_ticks, now - stats->chunk_start);
+               stat_add(&stats->timed_tasks, sched->timing_sample_rate);
+               stats->chunk_start = now;
+               stats->sample_countdown = sched->timing_sample_rate;
+           }
+           break;
+   }
+  
+   if (tls_sched == sched && !tls_draining && ws_deque_size(&sched->ready[tls_tid]) > 0) {
+       drain_local_ready(sched);
+   }
+   return elapsed;
+}
+
+
+static inline void run_task(TaskScheduler* sched, Task* task) {
+   run_task_measured(sched, task, false);
+}
+
+
+// Charges the calling worker's open chunk with the tasks it has counted so
+// far; the next task opens a new one.
+static void close_chunk(TaskScheduler* sched) {
+   WorkerStats* stats = &sched->worker_stats[tls_tid];
+   if (!stats->chunk_open) return;
+   int counted = sched->timing_sample_rate - stats->sample_countdown;
+   if (counted > 0) {
+       stat_add(&stats->timed_ticks, timing_now() - stats->chunk_start);
+       stat_add(&stats->timed_tasks, counted);
+   }
+   stats->chunk_open = false;
+}
+
+
+// Hands a node whose dependencies are satisfied to the calling worker's
+// ready deque, or to the shared queue when called from outside the pool.
+static void dag_release(TaskScheduler* sched, TaskNode* node) {
+   if (tls_sched == sched) {
+       atomic_fetch_add_explicit(&sched->ready_inflight, 1, memory_order_relaxed);
+       ws_deque_push(&sched->ready[tls_tid], (int64_t)(intptr_t)&node->exec);
+       return;
+   }
+   task_queue_enqueue(&sched->queue, node->exec.func, node->exec.arg, node->exec.weight, 0, node->exec.id);
+}
+
+
+static void dag_node_run(void* arg) {
+   TaskNode* node = arg;
+   node->func(node->arg);
+  
+   TaskEdge* edge = atomic_exchange_explicit(&node->successors, EDGES_CLOSED, memory_order_acq_rel);
+   while (edge) {
+       TaskEdge* next = edge->next;
+       if (atomic_fetch_sub_explicit(&edge->succ->pending, 1, memory_order_acq_rel) == 1) {
+           dag_release(node->sched, edge->succ);
        }
+       free(edge);
+       edge = next;
+   }
+}
+
+
+// Ready deques hold Task pointers: graph nodes' and spawned tasks' exec.
+static void run_ready_task(TaskScheduler* sched, Task* task) {
+   run_task(sched, task);
+   atomic_fetch_sub_explicit(&sched->ready_inflight, 1, memory_order_release);
+}
+
+
+static void drain_local_ready(TaskScheduler* sched) {
+   int64_t v;
+   tls_draining = true;
+   while ((v = ws_deque_pop(&sched->ready[tls_tid])) >= 0) {
+       run_ready_task(sched, (Task*)(intptr_t)v);
    }
+   tls_draining = false;
 }
 
 
-static void execute_task_dynamic(TaskScheduler* sched) {
-   int total = sched->tail;
+TaskNode* scheduler_submit_after(TaskScheduler* sched, TaskNode** deps, int ndeps,
+                                 void (*func)(void*), void* arg, TaskWeight weight) {
+   TaskNode* node = malloc(sizeof(TaskNode));
+   node->func = func;
+   node->arg = arg;
+   node->exec.func = dag_node_run;
+   node->exec.arg = node;
+   node->exec.weight = weight;
+   node->exec.size_class = 0;
+   node->exec.id = next_task_id(sched);
+   node->sched = sched;
+   atomic_init(&node->successors, NULL);
+   // One extra count keeps the node parked until every edge is linked.
+   atomic_init(&node->pending, ndeps + 1);
+   count_submission(sched);
   
-   #pragma omp parallel for schedule(dynamic, 1)
-   for (int i = 0; i < total; i++) {
-       uint64_t t_start = get_time_ns();
-       sched->task_queue[i].func(sched->task_queue[i].arg);
-       uint64_t t_end = get_time_ns();
-      
-       #pragma omp atomic
-       sched->metrics.total_exec_time_ns += (t_end - t_start);
-      
-       #pragma omp atomic
-       sched->metrics.tasks_completed++;
-      
-       #pragma omp atomic
-       sched->active_tasks--;
+   for (int d = 0; d < ndeps; d++) {
+       TaskEdge* edge = malloc(sizeof(TaskEdge));
+       edge->succ = node;
+       edge->next = atomic_load_explicit(&deps[d]->successors, memory_order_acquire);
+       while (edge->next != EDGES_CLOSED &&
+              !atomic_compare_exchange_weak_explicit(&deps[d]->successors, &edge->next, edge,
+                                                     memory_order_acq_rel, memory_order_acquire)) {
+       }
+       if (edge->next == EDGES_CLOSED) {
+           free(edge);
+           atomic_fetch_sub_explicit(&node->pending, 1, memory_order_acq_rel);
+       }
+   }
+  
+   if (atomic_fetch_sub_explicit(&node->pending, 1, memory_order_acq_rel) == 1) {
+       dag_release(sched, node);
+   }
+  
+   node->next_alloc = atomic_load_explicit(&sched->dag_nodes, memory_order_relaxed);
+   while (!atomic_compare_exchange_weak_explicit(&sched->dag_nodes, &node->next_alloc, node,
+                                                 memory_order_release, memory_order_relaxed)) {
+   }
+   return node;
+}
+
+
+// Explicit team barrier that charges the wait to the calling worker. Engines
+// use nowait worksharing plus this instead of implicit barriers.
+static void timed_barrier(TaskScheduler* sched) {
+   WorkerStats* stats = &sched->worker_stats[tls_tid];
+   uint64_t t_start = timing_now();
+   #pragma omp barrier
+   stat_add(&stats->barrier_ticks, timing_now() - t_start);
+}
+
+
+// Runs one ready task of the calling worker's deque, or failing that one
+// stolen from another worker. Returns false (after yielding) if none was
+// found.
+static bool run_one_ready(TaskScheduler* sched, uint32_t* seed) {
+   int nthreads = sched->num_threads;
+   uint64_t search_start = timing_now();
+   int64_t v = ws_deque_pop(&sched->ready[tls_tid]);
+   for (int k = 0; k < nthreads && v < 0; k++) {
+       int victim = (tls_tid + 1 + (int)(next_victim(seed) % nthreads)) % nthreads;
+       v = ws_deque_steal(&sched->ready[victim]);
+   }
+   if (v < 0) {
+       sched_yield();
+       stat_add(&sched->worker_stats[tls_tid].search_ticks, timing_now() - search_start);
+       return false;
    }
+   run_ready_task(sched, (Task*)(intptr_t)v);
+   return true;
 }
 
 
-static void execute_task_guided(TaskScheduler* sched) {
-   int total = sched->tail;
+// Keeps idle_workers counting the callers whose last search came up empty.
+static inline void track_idle(TaskScheduler* sched, bool* idle, bool now_idle) {
+   if (now_idle != *idle) {
+       atomic_fetch_add_explicit(&sched->idle_workers, now_idle ? 1 : -1, memory_order_relaxed);
+       *idle = now_idle;
+   }
+}
+
+
+// Runs released graph nodes and spawned tasks, stealing from other workers,
+// until none is left anywhere. Called by every worker before the batch
+// barrier.
+static void help_ready(TaskScheduler* sched) {
+   uint32_t seed = 0x9e3779b9u * (uint32_t)(tls_tid + 1);
+   bool idle = false;
+   while (atomic_load_explicit(&sched->ready_inflight, memory_order_acquire) > 0) {
+       track_idle(sched, &idle, !run_one_ready(sched, &seed));
+   }
+   track_idle(sched, &idle, false);
+}
+
+
+static void spawned_run(void* arg) {
+   SpawnedTask* spawned = arg;
+   TaskScheduler* sched = spawned->sched;
+   TaskGroup* group = spawned->group;
+   spawned->func(spawned->arg);
+   free(spawned);
+   // Both sequentially consistent, as in scheduler_sync: either the waiter
+   // sees the group finished or this sees the waiter.
+   if (atomic_fetch_sub_explicit(&group->pending, 1, memory_order_seq_cst) == 1 &&
+       atomic_load_explicit(&sched->sync_waiters, memory_order_seq_cst) > 0) {
+       pthread_mutex_lock(&sched->pool_lock);
+       pthread_cond_broadcast(&sched->done_cv);
+       pthread_mutex_unlock(&sched->pool_lock);
+   }
+}
+
+
+void scheduler_group_init(TaskGroup* group) {
+   atomic_init(&group->pending, 0);
+}
+
+
+void scheduler_spawn(TaskScheduler* sched, TaskGroup* group, void (*func)(void*), void* arg, TaskWeight weight) {
+   SpawnedTask* spawned = malloc(sizeof(SpawnedTask));
+   spawned->func = func;
+   spawned->arg = arg;
+   spawned->group = group;
+   spawned->sched = sched;
+   atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+   count_submission(sched);
+   int id = next_task_id(sched);
   
-   #pragma omp parallel for schedule(guided)
-   for (int i = 0; i < total; i++) {
-       uint64_t t_start = get_time_ns();
-       sched->task_queue[i].func(sched->task_queue[i].arg);
-       uint64_t t_end = get_time_ns();
-      
-       #pragma omp atomic
-       sched->metrics.total_exec_time_ns += (t_end - t_start);
-      
-       #pragma omp atomic
-       sched->metrics.tasks_completed++;
+   if (tls_sched == sched) {
+       spawned->exec.func = spawned_run;
+       spawned->exec.arg = spawned;
+       spawned->exec.weight = weight;
+       spawned->exec.size_class = 0;
+       spawned->exec.id = id;
+       atomic_fetch_add_explicit(&sched->ready_inflight, 1, memory_order_relaxed);
+       ws_deque_push(&sched->ready[tls_tid], (int64_t)(intptr_t)&spawned->exec);
+   } else {
+       task_queue_enqueue(&sched->queue, spawned_run, spawned, weight, 0, id);
+   }
+}
+
+
+void scheduler_sync(TaskScheduler* sched, TaskGroup* group) {
+   // Outside the pool there is nothing to help with, so block until the
+   // group's last task signals.
+   if (tls_sched != sched) {
+       if (atomic_load_explicit(&group->pending, memory_order_acquire) == 0) return;
+       scheduler_run(sched);
+       pthread_mutex_lock(&sched->pool_lock);
+       atomic_fetch_add_explicit(&sched->sync_waiters, 1, memory_order_seq_cst);
+       while (atomic_load_explicit(&group->pending, memory_order_seq_cst) > 0) {
+           pthread_cond_wait(&sched->done_cv, &sched->pool_lock);
+       }
+       atomic_fetch_sub_explicit(&sched->sync_waiters, 1, memory_order_relaxed);
+       pthread_mutex_unlock(&sched->pool_lock);
+       return;
+   }
+  
+   // Pops the worker's own children first, most recently spawned first.
+   uint32_t seed = 0x9e3779b9u * (uint32_t)(tls_tid + 1);
+   bool idle = false;
+   while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+       track_idle(sched, &idle, !run_one_ready(sched, &seed));
+   }
+   track_idle(sched, &idle, false);
+}
+
+
+typedef struct {
+   void (*body)(int begin, int end, void* ctx);
+   void* ctx;
+   int begin;
+   int end;
+   int grain;
+   uint8_t weight;
+} ForRange;
+
+// One scheduler_submit_range call: task i runs func(base + i * stride).
+typedef struct {
+   void (*func)(void*);
+   char* base;
+   size_t stride;
+} BulkRange;
+
+static void bulk_body(int begin, int end, void* ctx) {
+   BulkRange* bulk = ctx;
+   for (int i = begin; i < end; i++) {
+       bulk->func(bulk->base + (size_t)i * bulk->stride);
+   }
+}
+
+// Keyed like cost_model_key with size class 0; the sample is per iteration.
+// A bulk range's iterations are calls of its func, so they share its key.
+static inline uintptr_t range_cost_key(void (*body)(int, int, void*), void* ctx) {
+   if (body == bulk_body) return cost_model_key(((BulkRange*)ctx)->func, 0);
+   return (uintptr_t)body;
+}
+
+
+static int range_grain(TaskScheduler* sched, uintptr_t key, int count) {
+   int leaves = sched->num_threads * PARALLEL_FOR_MIN_LEAVES_PER_THREAD;
+   int grain = (count + leaves - 1) / leaves;
+   uint64_t per_iter;
+   if (cost_model_lookup(&sched->cost_model, key, &per_iter)) {
+       uint64_t target = PARALLEL_FOR_TARGET_NS / (per_iter > 0 ? per_iter : 1);
+       if (target < (uint64_t)grain) grain = (int)target;
+   }
+   return grain > 0 ? grain : 1;
+}
+
+
+int scheduler_parallel_for_grain(TaskScheduler* sched, void (*body)(int begin, int end, void* ctx), int count) {
+   return range_grain(sched, range_cost_key(body, NULL), count);
+}
+
+
+// Lazy binary splitting. Between grain-sized steps the range checks for an
+// idle worker; if there is one and the halves it split off earlier have all
+// been taken, the upper half of what is left goes to the ready deque for a
+// thief. Every split halves the rest, so 32 halves cover any int range;
+// they live in this frame until the sync.
+static void range_task(void* arg) {
+   TaskScheduler* sched = tls_sched;
+   ForRange* range = arg;
+   ForRange halves[32];
+   int nhalves = 0;
+   TaskGroup group;
+   scheduler_group_init(&group);
+  
+   // Counted as ready work while it runs, so idle workers stay in their
+   // search loops and can take its halves.
+   atomic_fetch_add_explicit(&sched->ready_inflight, 1, memory_order_relaxed);
+  
+   int begin = range->begin, end = range->end;
+   while (begin < end) {
+       if (end - begin >= 2 * range->grain &&
+           atomic_load_explicit(&sched->idle_workers, memory_order_relaxed) > 0 &&
+           ws_deque_size(&sched->ready[tls_tid]) == 0) {
+           int mid = begin + (end - begin) / 2;
+           halves[nhalves] = *range;
+           halves[nhalves].begin = mid;
+           halves[nhalves].end = end;
+           scheduler_spawn(sched, &group, range_task, &halves[nhalves], range->weight);
+           nhalves++;
+           end = mid;
+           continue;
+       }
       
-       #pragma omp atomic
-       sched->active_tasks--;
+       int stop = end - begin > range->grain ? begin + range->grain : end;
+       uint64_t t_start = timing_now();
+       range->body(begin, stop, range->ctx);
+       uint64_t ns = timing_ticks_to_ns(timing_now() - t_start);
+       cost_model_record(&sched->cost_model, tls_tid, range_cost_key(range->body, range->ctx),
+                         COST_WEIGHT_NONE, ns / (uint64_t)(stop - begin));
+       begin = stop;
    }
+  
+   stat_add(&sched->worker_stats[tls_tid].range_splits, nhalves);
+   atomic_fetch_sub_explicit(&sched->ready_inflight, 1, memory_order_release);
+   scheduler_sync(sched, &group);
 }
 
 
-static void execute_task_heterogeneous(TaskScheduler* sched) {
-   int total = sched->tail;
+// Cuts [begin, end) into one range per worker, fewer if the grain would
+// not fill them; returns the count.
+static int range_split_initial(TaskScheduler* sched, int begin, int end, void (*body)(int, int, void*),
+                               void* ctx, TaskWeight weight, ForRange* out) {
+   int count = end - begin;
+   int grain = range_grain(sched, range_cost_key(body, ctx), count);
+   int pieces = sched->num_threads;
+   if (pieces > count / grain) pieces = count / grain > 0 ? count / grain : 1;
   
-   Task* sorted = malloc(sizeof(Task) * total);
-   int light_count = 0, medium_count = 0, heavy_count = 0;
+   for (int p = 0; p < pieces; p++) {
+       out[p].body = body;
+       out[p].ctx = ctx;
+       out[p].begin = begin + (int)((int64_t)count * p / pieces);
+       out[p].end = begin + (int)((int64_t)count * (p + 1) / pieces);
+       out[p].grain = grain;
+       out[p].weight = weight;
+   }
+   return pieces;
+}
+
+
+void scheduler_parallel_for(TaskScheduler* sched, int begin, int end,
+                            void (*body)(int begin, int end, void* ctx), void* ctx) {
+   if (begin >= end) return;
+   ForRange* ranges = malloc(sizeof(ForRange) * sched->num_threads);
+   int pieces = range_split_initial(sched, begin, end, body, ctx, TASK_LIGHT, ranges);
+   TaskGroup group;
+   scheduler_group_init(&group);
+   for (int p = 0; p < pieces; p++) {
+       scheduler_spawn(sched, &group, range_task, &ranges[p], TASK_LIGHT);
+   }
+   scheduler_sync(sched, &group);
+   free(ranges);
+}
+
+
+static void submit_ranges(TaskScheduler* sched, int begin, int end, void (*body)(int, int, void*),
+                          void* ctx, TaskWeight weight) {
+   if (begin >= end) return;
+   ForRange* ranges = malloc(sizeof(ForRange) * sched->num_threads);
+   int pieces = range_split_initial(sched, begin, end, body, ctx, weight, ranges);
+   for (int p = 0; p < pieces; p++) {
+       // Node queues are drained through a shared cursor, so even without
+       // a home node a piece is never left to one busy worker.
+       int node = scheduler_home_node(sched, ranges[p].begin - begin, end - begin);
+       if (node < 0) node = p % sched->num_nodes;
+       scheduler_submit_on_node(sched, range_task, &ranges[p], sizeof(ForRange), weight, node);
+   }
+   free(ranges);
+}
+
+
+void scheduler_submit_splittable(TaskScheduler* sched, int begin, int end,
+                                 void (*body)(int begin, int end, void* ctx), void* ctx) {
+   submit_ranges(sched, begin, end, body, ctx, TASK_LIGHT);
+}
+
+
+bool scheduler_submit_range(TaskScheduler* sched, void (*func)(void*), void* base_arg, size_t stride,
+                            int count, TaskWeight weight) {
+   // Counted as one more task until its ranges are, so the descriptor is
+   // not reset away before they reach the queues.
+   count_submission(sched);
+   BulkRange* bulk = scheduler_alloc_arg(sched, sizeof(BulkRange));
+   bulk->func = func;
+   bulk->base = base_arg;
+   bulk->stride = stride;
+   submit_ranges(sched, 0, count, bulk_body, bulk, weight);
+   atomic_fetch_sub_explicit(&sched->active_tasks, 1, memory_order_release);
+   return true;
+}
+
+
+// Read only between folds, so engines may call it from any team thread.
+static inline uint64_t task_predicted_cost(TaskScheduler* sched, const Task* task) {
+   return cost_model_predict(&sched->cost_model, task_cost_key(task), task->weight);
+}
+
+
+// Engines are orphaned worksharing code: every thread of the persistent team
+// calls them together, and state they share lives in the scheduler.
+
+static void execute_task_static(TaskScheduler* sched, int begin, int end_idx) {
+   int total = end_idx - begin;
+   int tid = omp_get_thread_num();
+   int nthreads = omp_get_num_threads();
+   int chunk_size = (total + nthreads - 1) / nthreads;
+   int start = begin + tid * chunk_size;
+   int end = (start + chunk_size > end_idx) ? end_idx : start + chunk_size;
   
-   for (int i = 0; i < total; i++) {
-       if (sched->task_queue[i].weight == TASK_LIGHT) light_count++;
-       else if (sched->task_queue[i].weight == TASK_MEDIUM) medium_count++;
-       else heavy_count++;
+   for (int i = start; i < end; i++) {
+       run_task(sched, batch_task(sched, i));
    }
+}
+
+
+static void execute_task_dynamic(TaskScheduler* sched, int begin, int end) {
   
-   int light_idx = 0, medium_idx = light_count, heavy_idx = light_count + medium_count;
+   #pragma omp for schedule(dynamic, 1) nowait
+   for (int i = begin; i < end; i++) {
+       run_task(sched, batch_task(sched, i));
+   }
+}
+
+
+static void execute_task_guided(TaskScheduler* sched, int begin, int end) {
   
-   for (int i = 0; i < total; i++) {
-       if (sched->task_queue[i].weight == TASK_LIGHT)
-           sorted[light_idx++] = sched->task_queue[i];
-       else if (sched->task_queue[i].weight == TASK_MEDIUM)
-           sorted[medium_idx++] = sched->task_queue[i];
-       else
-           sorted[heavy_idx++] = sched->task_queue[i];
+   #pragma omp for schedule(guided) nowait
+   for (int i = begin; i < end; i++) {
+       run_task(sched, batch_task(sched, i));
+   }
+}
+
+
+// Called inside omp single. Contents are not preserved across growth.
+static void reserve_batch_scratch(TaskScheduler* sched, int total) {
+   if (total <= sched->batch_scratch_capacity) return;
+   int capacity = sched->batch_scratch_capacity > total / 2 ? 2 * sched->batch_scratch_capacity : total;
+   free(sched->batch_costs);
+   free(sched->batch_order);
+   free(sched->batch_sorted);
+   free(sched->batch_aux);
+   sched->batch_costs = malloc(sizeof(uint64_t) * capacity);
+   sched->batch_order = malloc(sizeof(int) * capacity);
+   sched->batch_sorted = malloc(sizeof(int) * capacity);
+   sched->batch_aux = malloc(sizeof(int) * capacity);
+   sched->batch_scratch_capacity = capacity;
+}
+
+
+// Splits [0, total) into one block per worker as execute_task_static
+// does: worker t's block is [blocks[t], blocks[t + 1]).
+static void prologue_blocks(int total, int nthreads, int* blocks) {
+   int chunk = (total + nthreads - 1) / nthreads;
+   for (int t = 0; t <= nthreads; t++) {
+       blocks[t] = t * chunk < total ? t * chunk : total;
    }
+}
+
+
+// Stable merge of the runs [lo, mid) and [mid, hi) of src into dst by
+// descending cost; on equal cost the left run goes first.
+static void merge_by_cost_desc(const int* src, int* dst, int lo, int mid, int hi, const uint64_t* costs) {
+   int a = lo, b = mid, k = lo;
+   while (a < mid && b < hi) dst[k++] = costs[src[b]] > costs[src[a]] ? src[b++] : src[a++];
+   while (a < mid) dst[k++] = src[a++];
+   while (b < hi) dst[k++] = src[b++];
+}
+
+
+// Stable bottom-up merge sort of batch positions by descending cost, so
+// equal costs keep submission order. tmp holds n entries.
+static void sort_by_cost_desc(int* idx, int* tmp, int n, const uint64_t* costs) {
+   int* src = idx;
+   int* dst = tmp;
+   for (int width = 1; width < n; width = width > n / 2 ? n : 2 * width) {
+       for (int lo = 0; lo < n;) {
+           int mid = lo + (width < n - lo ? width : n - lo);
+           int hi = mid + (width < n - mid ? width : n - mid);
+           merge_by_cost_desc(src, dst, lo, mid, hi, costs);
+           lo = hi;
+       }
+       int* swap = src;
+       src = dst;
+       dst = swap;
+   }
+   if (src != idx) memcpy(idx, src, sizeof(int) * n);
+}
+
+
+// Every team thread calls it with the same arguments. Merges the sorted
+// per-worker runs [runs[t], runs[t + 1]) of buf pairwise, one round and
+// barrier per doubling, ping-ponging with tmp at the same offsets. Returns
+// whichever of buf and tmp holds the merged run.
+static int* merge_worker_runs(TaskScheduler* sched, int* buf, int* tmp, const int* runs, const uint64_t* costs) {
+   int tid = omp_get_thread_num();
+   int nthreads = omp_get_num_threads();
+   int* src = buf;
+   int* dst = tmp;
+   for (int step = 1; step < nthreads; step *= 2) {
+       if (tid % (2 * step) == 0) {
+           int mid = tid + step < nthreads ? tid + step : nthreads;
+           int hi = tid + 2 * step < nthreads ? tid + 2 * step : nthreads;
+           merge_by_cost_desc(src, dst, runs[tid], runs[mid], runs[hi], costs);
+       }
+       timed_barrier(sched);
+       int* swap = src;
+       src = dst;
+       dst = swap;
+   }
+   return src;
+}
+
+
+static void execute_task_heterogeneous(TaskScheduler* sched, int begin, int end) {
+   int total = end - begin;
+   int tid = omp_get_thread_num();
+   int nthreads = omp_get_num_threads();
+  
+   #pragma omp single nowait
+   reserve_batch_scratch(sched, total);
+   timed_barrier(sched);
+  
+   // Tasks predicted below half the batch mean are split statically in
+   // submission order; the rest follow, most expensive first. Each worker
+   // costs, counts and scatters its own block of the batch.
+   uint64_t* costs = sched->batch_costs;
+   int* order = sched->batch_order;
+   int* counts = sched->prologue_counts;
+   int blocks[nthreads + 1];
+   prologue_blocks(total, nthreads, blocks);
+   double sum = 0.0;
+   for (int i = blocks[tid]; i < blocks[tid + 1]; i++) {
+       costs[i] = task_predicted_cost(sched, batch_task(sched, begin + i));
+       sum += costs[i];
+   }
+   sched->prologue_sums[tid] = sum;
+   timed_barrier(sched);
+  
+   double mean = 0.0;
+   for (int t = 0; t < nthreads; t++) mean += sched->prologue_sums[t];
+   mean /= total;
+   int light = 0;
+   for (int i = blocks[tid]; i < blocks[tid + 1]; i++) {
+       if (costs[i] < mean / 2) light++;
+   }
+   counts[2 * tid] = light;
+   counts[2 * tid + 1] = blocks[tid + 1] - blocks[tid] - light;
+   timed_barrier(sched);
+  
+   // Light tasks fill the front block by block; each worker's heavy tasks
+   // form a run after them, sorted here and merged below.
+   int light_count = 0, light_pos = 0;
+   for (int t = 0; t < nthreads; t++) {
+       if (t == tid) light_pos = light_count;
+       light_count += counts[2 * t];
+   }
+   int runs[nthreads + 1];
+   runs[0] = light_count;
+   for (int t = 0; t < nthreads; t++) runs[t + 1] = runs[t] + counts[2 * t + 1];
+   int heavy_pos = runs[tid];
+   for (int i = blocks[tid]; i < blocks[tid + 1]; i++) {
+       if (costs[i] < mean / 2) {
+           order[light_pos++] = i;
+       } else {
+           order[heavy_pos++] = i;
+       }
+   }
+   sort_by_cost_desc(order + runs[tid], sched->batch_aux + runs[tid], runs[tid + 1] - runs[tid], costs);
+   timed_barrier(sched);
+  
+   int* heavy = merge_worker_runs(sched, order, sched->batch_aux, runs, costs);
+   if (heavy != order) {
+       memcpy(order + runs[tid], heavy + runs[tid], sizeof(int) * (runs[tid + 1] - runs[tid]));
+       timed_barrier(sched);
+   }
+  
+   int light_chunk = (light_count + nthreads - 1) / nthreads;
+   int start = tid * light_chunk;
+   int stop = (start + light_chunk > light_count) ? light_count : start + light_chunk;
   
-   #pragma omp parallel
+   for (int i = start; i < stop; i++) {
+       run_task(sched, batch_task(sched, begin + order[i]));
+   }
+  
+   #pragma omp for schedule(dynamic, 1) nowait
+   for (int i = light_count; i < total; i++) {
+       run_task(sched, batch_task(sched, begin + order[i]));
+   }
+  
+   timed_barrier(sched);
+}
+
+
+// Binary min-heap of (load, worker) for the greedy least-loaded assignment.
+typedef struct {
+   uint64_t load;
+   int tid;
+} LptLoad;
+
+static void lpt_sift_down(LptLoad* heap, int n, int i) {
+   while (1) {
+       int smallest = i;
+       int l = 2 * i + 1, r = 2 * i + 2;
+       if (l < n && heap[l].load < heap[smallest].load) smallest = l;
+       if (r < n && heap[r].load < heap[smallest].load) smallest = r;
+       if (smallest == i) return;
+       LptLoad tmp = heap[i];
+       heap[i] = heap[smallest];
+       heap[smallest] = tmp;
+       i = smallest;
+   }
+}
+
+
+// Longest processing time first: tasks are sorted by descending estimated
+// cost and each goes to the worker with the least estimated load so far.
+// Every worker then runs its own list largest first; a worker that runs dry
+// takes the next unstarted task from the other lists, which covers
+// estimation error.
+static void execute_task_lpt(TaskScheduler* sched, int begin, int end) {
+   int total = end - begin;
+   int tid = omp_get_thread_num();
+   int nthreads = omp_get_num_threads();
+  
+   #pragma omp single nowait
+   reserve_batch_scratch(sched, total);
+   timed_barrier(sched);
+  
+   // Each worker costs and sorts its own block; the blocks are then merged.
+   uint64_t* costs = sched->batch_costs;
+   int* counts = sched->prologue_counts;
+   int blocks[nthreads + 1];
+   prologue_blocks(total, nthreads, blocks);
+   int* sorted = sched->batch_sorted;
+   for (int i = blocks[tid]; i < blocks[tid + 1]; i++) {
+       costs[i] = task_predicted_cost(sched, batch_task(sched, begin + i));
+       sorted[i] = i;
+   }
+   sort_by_cost_desc(sorted + blocks[tid], sched->batch_aux + blocks[tid], blocks[tid + 1] - blocks[tid], costs);
+   timed_barrier(sched);
+  
+   sorted = merge_worker_runs(sched, sorted, sched->batch_aux, blocks, costs);
+   int* owner = sorted == sched->batch_sorted ? sched->batch_aux : sched->batch_sorted;
+  
+   // The greedy assignment is sequential, but only walks the cost array.
+   #pragma omp single nowait
    {
-       int tid = omp_get_thread_num();
-       int nthreads = omp_get_num_threads();
-      
-       int light_chunk = (light_count + nthreads - 1) / nthreads;
-       int start = tid * light_chunk;
-       int end = (start + light_chunk > light_count) ? light_count : start + light_chunk;
-      
-       for (int i = start; i < end; i++) {
-           uint64_t t_start = get_time_ns();
-           sorted[i].func(sorted[i].arg);
-           uint64_t t_end = get_time_ns();
-          
-           #pragma omp atomic
-           sched->metrics.total_exec_time_ns += (t_end - t_start);
-          
-           #pragma omp atomic
-           sched->metrics.tasks_completed++;
-          
-           #pragma omp atomic
-           sched->active_tasks--;
+       LptLoad heap[nthreads];
+       for (int t = 0; t < nthreads; t++) {
+           heap[t].load = 0;
+           heap[t].tid = t;
+       }
+       for (int i = 0; i < total; i++) {
+           owner[i] = heap[0].tid;
+           heap[0].load += costs[sorted[i]];
+           lpt_sift_down(heap, nthreads, 0);
+       }
+   }
+   timed_barrier(sched);
+  
+   // Per-worker histograms of owners over each block, then a scatter in
+   // block order, which keeps every list in descending cost order.
+   int* row = &counts[tid * nthreads];
+   memset(row, 0, sizeof(int) * nthreads);
+   for (int i = blocks[tid]; i < blocks[tid + 1]; i++) {
+       row[owner[i]]++;
+   }
+   timed_barrier(sched);
+  
+   int offset[nthreads];
+   int list_start = 0;
+   for (int w = 0; w < nthreads; w++) {
+       if (w == tid) {
+           sched->lpt_bounds[w] = list_start;
+           atomic_store_explicit(&sched->lpt_cursors[w].next, list_start, memory_order_relaxed);
+       }
+       offset[w] = list_start;
+       for (int t = 0; t < nthreads; t++) {
+           if (t < tid) offset[w] += counts[t * nthreads + w];
+           list_start += counts[t * nthreads + w];
        }
+   }
+   if (tid == nthreads - 1) sched->lpt_bounds[nthreads] = total;
+   int* order = sched->batch_order;
+   for (int i = blocks[tid]; i < blocks[tid + 1]; i++) {
+       order[offset[owner[i]]++] = sorted[i];
+   }
+   timed_barrier(sched);
+  
+   int* bounds = sched->lpt_bounds;
+   for (int k = 0; k < nthreads; k++) {
+       int t = (tid + k) % nthreads;
+       int i;
+       while ((i = atomic_fetch_add_explicit(&sched->lpt_cursors[t].next, 1, memory_order_relaxed)) < bounds[t + 1]) {
+           run_task(sched, batch_task(sched, begin + order[i]));
+       }
+   }
+  
+   timed_barrier(sched);
+}
+
+
+static void execute_task_work_stealing(TaskScheduler* sched, int begin, int end_idx) {
+   int total = end_idx - begin;
+   int tid = omp_get_thread_num();
+   int nthreads = omp_get_num_threads();
+   WSDeque* own = &sched->deques[tid];
+   int chunk_size = (total + nthreads - 1) / nthreads;
+   int start = begin + tid * chunk_size;
+   int end = (start + chunk_size > end_idx) ? end_idx : start + chunk_size;
+  
+   // Seed in reverse so the owner pops its block in submission order
+   // while thieves take from the far end.
+   for (int i = end - 1; i >= start; i--) {
+       ws_deque_push(own, i);
+   }
+  
+   timed_barrier(sched);
+  
+   uint32_t seed = 2654435761u * (uint32_t)(tid + 1);
+   uint64_t steal_attempts = 0, steals = 0;
+  
+   while (1) {
+       int64_t idx = ws_deque_pop(own);
       
-       #pragma omp for schedule(dynamic, 1)
-       for (int i = light_count; i < total; i++) {
-           uint64_t t_start = get_time_ns();
-           sorted[i].func(sorted[i].arg);
-           uint64_t t_end = get_time_ns();
-          
-           #pragma omp atomic
-           sched->metrics.total_exec_time_ns += (t_end - t_start);
-          
-           #pragma omp atomic
-           sched->metrics.tasks_completed++;
-          
-           #pragma omp atomic
-           sched->active_tasks--;
+       if (idx == WS_DEQUE_EMPTY) {
+           uint64_t search_start = timing_now();
+           // Sweep every victim from a random start. Nothing is pushed
+           // after the seeding barrier, so a sweep that sees only empty
+           // deques (no aborted steals) means the run is drained.
+           bool contended = false;
+           uint32_t first = next_victim(&seed) % nthreads;
+           for (int k = 0; k < nthreads && idx < 0; k++) {
+               int victim = (first + k) % nthreads;
+               if (victim == tid) continue;
+               steal_attempts++;
+               idx = ws_deque_steal(&sched->deques[victim]);
+               if (idx == WS_DEQUE_ABORT) contended = true;
+           }
+           stat_add(&sched->worker_stats[tid].search_ticks, timing_now() - search_start);
+           if (idx < 0) {
+               if (contended) continue;
+               break;
+           }
+           steals++;
        }
+      
+       run_task(sched, batch_task(sched, idx));
    }
   
-   free(sorted);
+   stat_add(&sched->worker_stats[tid].steal_attempts, steal_attempts);
+   stat_add(&sched->worker_stats[tid].steals, steals);
 }
 
 
-void scheduler_run(TaskScheduler* sched) {
-   sched->running = true;
+static uint64_t drain_local_queue(TaskScheduler* sched, LocalQueue* lq) {
+   uint64_t ran = 0;
+   int i;
+   while ((i = atomic_fetch_add_explicit(&lq->next, 1, memory_order_relaxed)) < lq->batch_count) {
+       run_task(sched, task_queue_at(&lq->queue, lq->batch_base + i));
+       ran++;
+   }
+   return ran;
+}
+
+
+// Runs the claimed worker and node batches after the shared one. A worker
+// takes its own keyed tasks, then its node's, then keyed tasks of workers
+// on its L3 before the others', and other nodes' tasks last. Unpinned
+// workers spread over the nodes and share no L3.
+static void execute_local_queues(TaskScheduler* sched) {
+   int tid = omp_get_thread_num();
+   int nthreads = omp_get_num_threads();
+   int home = scheduler_worker_node(sched, tid);
+   bool pinned = home >= 0;
+   if (!pinned) home = tid % sched->num_nodes;
+   uint64_t displaced = 0, remote = 0;
   
-   switch (sched->mode) {
+   // Counted as ready work while draining: a worker that has taken a range
+   // but not started it yet still keeps finished workers in help_ready,
+   // where they count as idle and the range can split for them.
+   atomic_fetch_add_explicit(&sched->ready_inflight, 1, memory_order_relaxed);
+   drain_local_queue(sched, &sched->worker_queues[tid]);
+   drain_local_queue(sched, &sched->node_queues[home]);
+   for (int near = 1; near >= 0; near--) {
+       for (int k = 1; k < nthreads; k++) {
+           int t = (tid + k) % nthreads;
+           if (scheduler_workers_share(sched, tid, t, TOPO_L3) != near) continue;
+           displaced += drain_local_queue(sched, &sched->worker_queues[t]);
+       }
+   }
+   for (int k = 1; k < sched->num_nodes; k++) {
+       uint64_t ran = drain_local_queue(sched, &sched->node_queues[(home + k) % sched->num_nodes]);
+       if (pinned) remote += ran;
+   }
+   atomic_fetch_sub_explicit(&sched->ready_inflight, 1, memory_order_release);
+   stat_add(&sched->worker_stats[tid].displaced_tasks, displaced);
+   stat_add(&sched->worker_stats[tid].remote_tasks, remote);
+}
+
+
+static void execute_task_adaptive(TaskScheduler* sched, int begin, int end);
+
+
+static void dispatch_range(TaskScheduler* sched, ScheduleMode mode, int begin, int end) {
+   if (begin >= end) return;
+  
+   switch (mode) {
        case SCHEDULE_STATIC:
-           execute_task_static(sched);
+           execute_task_static(sched, begin, end);
            break;
        case SCHEDULE_DYNAMIC:
-           execute_task_dynamic(sched);
+           execute_task_dynamic(sched, begin, end);
            break;
        case SCHEDULE_GUIDED:
-           execute_task_guided(sched);
+           execute_task_guided(sched, begin, end);
            break;
        case SCHEDULE_HETEROGENEOUS:
-           execute_task_heterogeneous(sched);
+           execute_task_heterogeneous(sched, begin, end);
            break;
        case SCHEDULE_ADAPTIVE:
-           execute_task_heterogeneous(sched);
+           execute_task_adaptive(sched, begin, end);
+           break;
+       case SCHEDULE_WORK_STEALING:
+           execute_task_work_stealing(sched, begin, end);
+           break;
+       case SCHEDULE_LPT:
+           execute_task_lpt(sched, begin, end);
            break;
    }
+}
+
+
+// Picks the engine for the rest of a batch from the probe phase statistics.
+// cv is the coefficient of variation of task durations, imbalance is how far
+// the busiest thread ran past the mean under a static split.
+static ScheduleMode adaptive_select(TaskScheduler* sched, double cv, double imbalance, int remaining) {
+   double threshold = sched->variance_threshold;
   
-   sched->running = false;
+   if (cv <= threshold && imbalance <= threshold) return SCHEDULE_STATIC;
+   if (cv <= 2.0 * threshold) return SCHEDULE_GUIDED;
+   if (remaining / sched->num_threads >= ADAPTIVE_STEAL_MIN_PER_THREAD) return SCHEDULE_WORK_STEALING;
+   return SCHEDULE_DYNAMIC;
+}
+
+
+// Coefficient of variation of costs, and how far the busiest of the
+// per-thread totals is above their mean.
+static void cost_spread(const uint64_t* costs, int n, const uint64_t* busy, int nthreads,
+                        double* cv, double* imbalance) {
+   double mean = 0.0, var = 0.0;
+   for (int i = 0; i < n; i++) mean += costs[i];
+   mean /= n;
+   for (int i = 0; i < n; i++) var += (costs[i] - mean) * (costs[i] - mean);
+   var /= n;
+   *cv = mean > 0.0 ? sqrt(var) / mean : 0.0;
+  
+   double busy_mean = 0.0, busy_max = 0.0;
+   for (int t = 0; t < nthreads; t++) {
+       busy_mean += busy[t];
+       if (busy[t] > busy_max) busy_max = busy[t];
+   }
+   busy_mean /= nthreads;
+   *imbalance = busy_mean > 0.0 ? (busy_max - busy_mean) / busy_mean : 0.0;
+}
+
+
+// Selects the engine from the cost model when every task in the batch has
+// been measured before; returns false if a probe is needed instead.
+static bool adaptive_select_predicted(TaskScheduler* sched, int begin, int end, int nthreads) {
+   int total = end - begin;
+   uint64_t* costs = malloc(sizeof(uint64_t) * total);
+   uint64_t* busy = calloc(nthreads, sizeof(uint64_t));
+   int chunk = (total + nthreads - 1) / nthreads;
+   bool known = true;
+  
+   for (int i = 0; i < total && known; i++) {
+       known = cost_model_lookup(&sched->cost_model, task_cost_key(batch_task(sched, begin + i)), &costs[i]);
+       if (known) busy[i / chunk] += costs[i];
+   }
+   if (known) {
+       double cv, imbalance;
+       cost_spread(costs, total, busy, nthreads, &cv, &imbalance);
+       sched->adaptive_mode = adaptive_select(sched, cv, imbalance, total);
+   }
+   free(costs);
+   free(busy);
+   return known;
+}
+
+
+static void execute_task_adaptive(TaskScheduler* sched, int begin, int end) {
+   int total = end - begin;
+   int tid = omp_get_thread_num();
+   int nthreads = omp_get_num_threads();
+  
+   #pragma omp single nowait
+   {
+       int probe = 0;
+       if (!adaptive_select_predicted(sched, begin, end, nthreads)) {
+           probe = total / ADAPTIVE_PROBE_FRACTION;
+           if (probe < nthreads * ADAPTIVE_PROBE_MIN_PER_THREAD) probe = nthreads * ADAPTIVE_PROBE_MIN_PER_THREAD;
+           if (probe > total) probe = total;
+           sched->probe_durations = malloc(sizeof(uint64_t) * probe);
+           sched->probe_busy = calloc(nthreads, sizeof(uint64_t));
+       }
+       sched->adaptive_probe = probe;
+   }
+   timed_barrier(sched);
+  
+   int probe = sched->adaptive_probe;
+   if (probe > 0) {
+       uint64_t* durations = sched->probe_durations;
+       uint64_t my_busy = 0;
+      
+       // Phase 1: static split, so per-thread busy time shows what a static
+       // schedule would cost on this batch.
+       #pragma omp for schedule(static) nowait
+       for (int i = 0; i < probe; i++) {
+           durations[i] = run_task_measured(sched, batch_task(sched, begin + i), true);
+           my_busy += durations[i];
+       }
+       sched->probe_busy[tid] = my_busy;
+       timed_barrier(sched);
+      
+       #pragma omp single nowait
+       {
+           double cv, imbalance;
+           cost_spread(durations, probe, sched->probe_busy, nthreads, &cv, &imbalance);
+           free(durations);
+           free(sched->probe_busy);
+           sched->adaptive_mode = adaptive_select(sched, cv, imbalance, total - probe);
+       }
+       timed_barrier(sched);
+   }
+  
+   // Phase 2: the rest of the batch under the selected engine.
+   dispatch_range(sched, sched->adaptive_mode, begin + probe, end);
+}
+
+
+// Claims the next batch. A producer that has reserved a slot but not yet
+// published it is waited for, so nothing submitted before the claim is left
+// behind when the pool goes idle.
+static size_t claim_batch(TaskQueue* queue, size_t* first) {
+   size_t count;
+   while ((count = task_queue_claim(queue, first)) == 0 && task_queue_size(queue) > 0) {
+       sched_yield();
+   }
+   return count;
+}
+
+
+static int claim_local_batch(LocalQueue* lq) {
+   if (lq->batch_count > 0) {
+       task_queue_release(&lq->queue, lq->batch_base, lq->batch_count);
+   }
+   lq->batch_count = (int)claim_batch(&lq->queue, &lq->batch_base);
+   atomic_store_explicit(&lq->next, 0, memory_order_relaxed);
+   return lq->batch_count;
+}
+
+
+static void pool_drain(TaskScheduler* sched) {
+   WorkerStats* stats = &sched->worker_stats[omp_get_thread_num()];
+  
+   while (1) {
+       // The previous batch is released in the same single that claims the
+       // next one; the barrier below the engines guarantees it is finished.
+       #pragma omp single nowait
+       {
+           if (sched->batch_count > 0) {
+               task_queue_release(&sched->queue, sched->batch_base, sched->batch_count);
+           }
+           // Samples of the finished batch inform the engines' next prologue.
+           cost_model_fold(&sched->cost_model);
+           sched->batch_count = claim_batch(&sched->queue, &sched->batch_base);
+          
+           sched->local_batch_count = 0;
+           for (int n = 0; n < sched->num_nodes; n++) {
+               sched->local_batch_count += claim_local_batch(&sched->node_queues[n]);
+           }
+           for (int t = 0; t < sched->num_threads; t++) {
+               sched->local_batch_count += claim_local_batch(&sched->worker_queues[t]);
+           }
+       }
+       timed_barrier(sched);
+      
+       if (sched->batch_count == 0 && sched->local_batch_count == 0) break;
+      
+       uint64_t completed_before = atomic_load_explicit(&stats->tasks_completed, memory_order_relaxed);
+      
+       // A worker's chunk is closed once its batch tasks are done and again
+       // after the ready tasks, so a share under one chunk is still timed
+       // and the barrier is never charged. SAMPLED's countdown carries over
+       // from batch to batch.
+       dispatch_range(sched, sched->mode, 0, (int)sched->batch_count);
+       if (sched->local_batch_count > 0) execute_local_queues(sched);
+       close_chunk(sched);
+       help_ready(sched);
+       close_chunk(sched);
+      
+       // One update per worker per batch keeps the in-flight count exact at
+       // batch boundaries without touching shared memory per task.
+       int completed = (int)(atomic_load_explicit(&stats->tasks_completed, memory_order_relaxed) - completed_before);
+       atomic_fetch_sub_explicit(&sched->active_tasks, completed, memory_order_release);
+      
+       timed_barrier(sched);
+   }
+}
+
+
+static void* pool_main(void* arg) {
+   TaskScheduler* sched = arg;
+  
+   #pragma omp parallel num_threads(sched->num_threads)
+   {
+       tls_sched = sched;
+       tls_tid = omp_get_thread_num();
+       int cpu = sched->worker_cpus[tls_tid];
+       if (cpu >= 0 && affinity_pin_self(cpu) != 0) sched->worker_cpus[tls_tid] = -1;
+      
+       #pragma omp barrier
+       #pragma omp master
+       {
+           pthread_mutex_lock(&sched->pool_lock);
+           sched->pool_ready = true;
+           pthread_cond_broadcast(&sched->done_cv);
+           pthread_mutex_unlock(&sched->pool_lock);
+       }
+      
+       while (1) {
+           #pragma omp master
+           {
+               pthread_mutex_lock(&sched->pool_lock);
+               while (sched->run_requests == sched->runs_served && !sched->shutdown) {
+                   pthread_cond_wait(&sched->work_cv, &sched->pool_lock);
+               }
+               sched->runs_served = sched->run_requests;
+               sched->pool_exit = sched->shutdown;
+               pthread_mutex_unlock(&sched->pool_lock);
+           }
+          
+           #pragma omp barrier
+          
+           if (sched->pool_exit) break;
+          
+           pool_drain(sched);
+          
+           // Let every worker finish charging its last barrier before the
+           // counters are folded.
+           #pragma omp barrier
+          
+           #pragma omp master
+           {
+               pthread_mutex_lock(&sched->pool_lock);
+               if (sched->run_requests == sched->runs_served) {
+                   scheduler_snapshot_metrics(sched, &sched->metrics);
+                   sched->running = false;
+                   pthread_cond_broadcast(&sched->done_cv);
+               }
+               pthread_mutex_unlock(&sched->pool_lock);
+           }
+       }
+   }
+   return NULL;
+}
+
+
+void scheduler_run(TaskScheduler* sched) {
+   pthread_mutex_lock(&sched->pool_lock);
+   sched->running = true;
+   sched->run_requests++;
+   sched->run_since_wait = true;
+   pthread_cond_signal(&sched->work_cv);
+   pthread_mutex_unlock(&sched->pool_lock);
+}
+
+
+void* scheduler_alloc_arg(TaskScheduler* sched, size_t size) {
+   return task_arena_alloc(&sched->arena, size);
+}
+
+
+static bool queues_pending(TaskScheduler* sched) {
+   if (task_queue_size(&sched->queue) > 0) return true;
+   for (int n = 0; n < sched->num_nodes; n++) {
+       if (task_queue_size(&sched->node_queues[n].queue) > 0) return true;
+   }
+   for (int t = 0; t < sched->num_threads; t++) {
+       if (task_queue_size(&sched->worker_queues[t].queue) > 0) return true;
+   }
+   return false;
 }
 
 
 void scheduler_wait(TaskScheduler* sched) {
-   while (sched->active_tasks > 0) {
-       usleep(100);
+   pthread_mutex_lock(&sched->pool_lock);
+   while (1) {
+       while (sched->running) {
+           pthread_cond_wait(&sched->done_cv, &sched->pool_lock);
+       }
+       // Submissions take no lock, so one can land after the pool's last
+       // claim but before it went idle. It belongs to the run being waited
+       // for: run again.
+       if (!sched->run_since_wait || !queues_pending(sched)) break;
+       sched->running = true;
+       sched->run_requests++;
+       pthread_cond_signal(&sched->work_cv);
+   }
+   sched->run_since_wait = false;
+   // Every submitted task has finished, so the argument epoch can go. The
+   // hold keeps a submitter racing this wait out of the arena meanwhile.
+   int idle = 0;
+   if (atomic_compare_exchange_strong_explicit(&sched->active_tasks, &idle, ARENA_RESET_HOLD,
+                                               memory_order_acquire, memory_order_relaxed)) {
+       task_arena_reset(&sched->arena);
+       atomic_fetch_sub_explicit(&sched->active_tasks, ARENA_RESET_HOLD, memory_order_release);
+   }
+   pthread_mutex_unlock(&sched->pool_lock);
+}
+
+
+static void free_dag_nodes(TaskScheduler* sched) {
+   TaskNode* node = atomic_exchange_explicit(&sched->dag_nodes, NULL, memory_order_acquire);
+   while (node) {
+       TaskNode* next = node->next_alloc;
+       TaskEdge* edge = atomic_load_explicit(&node->successors, memory_order_relaxed);
+       while (edge && edge != EDGES_CLOSED) {
+           TaskEdge* next_edge = edge->next;
+           free(edge);
+           edge = next_edge;
+       }
+       free(node);
+       node = next;
+   }
+}
+
+
+bool scheduler_reset(TaskScheduler* sched) {
+   scheduler_wait(sched);
+   if (atomic_load_explicit(&sched->active_tasks, memory_order_acquire) != 0) return false;
+  
+   // The pool is parked, so nothing else touches the counters. Queue
+   // segments, arena blocks, deques and the cost model are kept as they are.
+   free_dag_nodes(sched);
+   memset(sched->worker_stats, 0, sizeof(WorkerStats) * sched->num_threads);
+   pthread_mutex_lock(&sched->pool_lock);
+   memset(&sched->metrics, 0, sizeof(sched->metrics));
+   pthread_mutex_unlock(&sched->pool_lock);
+   atomic_store_explicit(&sched->next_task_id, 0, memory_order_relaxed);
+   return true;
+}
+
+
+void scheduler_enable_trace(TaskScheduler* sched, const char* path) {
+   if (sched->trace) return;
+  
+   sched->trace = aligned_alloc(64, sizeof(TraceBuffer) * sched->num_threads);
+   for (int t = 0; t < sched->num_threads; t++) {
+       trace_buffer_init(&sched->trace[t]);
    }
+   sched->trace_path = strdup(path);
+   sched->trace_origin = timing_now();
 }
 
 
 void scheduler_destroy(TaskScheduler* sched) {
-   free(sched->task_queue);
+   scheduler_wait(sched);
+  
+   pthread_mutex_lock(&sched->pool_lock);
+   sched->shutdown = true;
+   pthread_cond_signal(&sched->work_cv);
+   pthread_mutex_unlock(&sched->pool_lock);
+   pthread_join(sched->pool_thread, NULL);
+  
+   pthread_cond_destroy(&sched->done_cv);
+   pthread_cond_destroy(&sched->work_cv);
+   pthread_mutex_destroy(&sched->pool_lock);
+  
+   for (int i = 0; i < sched->num_threads; i++) {
+       ws_deque_destroy(&sched->deques[i]);
+       ws_deque_destroy(&sched->ready[i]);
+   }
+   free(sched->deques);
+   free(sched->ready);
+   task_arena_destroy(&sched->arena);
+   free(sched->worker_stats);
+   free(sched->lpt_cursors);
+   free(sched->lpt_bounds);
+   free(sched->prologue_sums);
+   free(sched->prologue_counts);
+   free(sched->batch_costs);
+   free(sched->batch_order);
+   free(sched->batch_sorted);
+   free(sched->batch_aux);
+   free(sched->worker_cpus);
+   for (int n = 0; n < sched->num_nodes; n++) {
+       task_queue_destroy(&sched->node_queues[n].queue);
+   }
+   free(sched->node_queues);
+   for (int t = 0; t < sched->num_threads; t++) {
+       task_queue_destroy(&sched->worker_queues[t].queue);
+   }
+   free(sched->worker_queues);
+   cost_model_destroy(&sched->cost_model);
+  
+   if (sched->trace) {
+       if (trace_write_chrome(sched->trace_path, sched->trace, sched->num_threads, sched->trace_origin) != 0) {
+           fprintf(stderr, "scheduler: could not write trace to %s\n", sched->trace_path);
+       }
+       for (int t = 0; t < sched->num_threads; t++) {
+           trace_buffer_destroy(&sched->trace[t]);
+       }
+       free(sched->trace);
+       free(sched->trace_path);
+   }
+  
+   free_dag_nodes(sched);
+   task_queue_destroy(&sched->queue);
+}
+
+
+void scheduler_set_timing(TaskScheduler* sched, TimingMode mode, int sample_rate) {
+   sched->timing_mode = mode;
+   sched->timing_sample_rate = (mode == TIMING_EVERY_TASK || sample_rate < 1) ? 1 : sample_rate;
+}
+
+
+static void fill_derived_metrics(RuntimeMetrics* m) {
+   m->avg_exec_time_ms = m->tasks_completed > 0 ? (m->total_exec_time_ns / 1e6) / m->tasks_completed : 0.0;
+   uint64_t accounted = m->total_exec_time_ns + m->idle_time_ns;
+   m->idle_ratio = accounted > 0 ? (double)m->idle_time_ns / accounted : 0.0;
+}
+
+
+void scheduler_get_thread_metrics(TaskScheduler* sched, int tid, RuntimeMetrics* out) {
+   WorkerStats* stats = &sched->worker_stats[tid];
+   memset(out, 0, sizeof(*out));
+   out->tasks_completed = atomic_load_explicit(&stats->tasks_completed, memory_order_relaxed);
+  
+   // Sampled modes time a subset of tasks; scale up to the completed count.
+   uint64_t timed_tasks = atomic_load_explicit(&stats->timed_tasks, memory_order_relaxed);
+   uint64_t timed_ns = timing_ticks_to_ns(atomic_load_explicit(&stats->timed_ticks, memory_order_relaxed));
+   if (timed_tasks >= out->tasks_completed) {
+       out->total_exec_time_ns = timed_ns;
+   } else if (timed_tasks > 0) {
+       out->total_exec_time_ns = (uint64_t)((double)timed_ns * out->tasks_completed / timed_tasks);
+   }
+   out->steal_attempts = atomic_load_explicit(&stats->steal_attempts, memory_order_relaxed);
+   out->steals = atomic_load_explicit(&stats->steals, memory_order_relaxed);
+   out->remote_tasks = atomic_load_explicit(&stats->remote_tasks, memory_order_relaxed);
+   out->displaced_tasks = atomic_load_explicit(&stats->displaced_tasks, memory_order_relaxed);
+   out->range_splits = atomic_load_explicit(&stats->range_splits, memory_order_relaxed);
+  
+   out->barrier_wait_ns = timing_ticks_to_ns(atomic_load_explicit(&stats->barrier_ticks, memory_order_relaxed));
+   out->work_search_ns = timing_ticks_to_ns(atomic_load_explicit(&stats->search_ticks, memory_order_relaxed));
+   out->idle_time_ns = out->barrier_wait_ns + out->work_search_ns;
+   fill_derived_metrics(out);
+}
+
+
+// Reads only the per-worker atomics, never sched->metrics, which the pool
+// master rewrites from here as it goes idle.
+void scheduler_snapshot_metrics(TaskScheduler* sched, RuntimeMetrics* out) {
+   RuntimeMetrics total;
+   memset(&total, 0, sizeof(total));
+  
+   for (int t = 0; t < sched->num_threads; t++) {
+       RuntimeMetrics thread;
+       scheduler_get_thread_metrics(sched, t, &thread);
+       total.tasks_completed += thread.tasks_completed;
+       total.total_exec_time_ns += thread.total_exec_time_ns;
+       total.steal_attempts += thread.steal_attempts;
+       total.steals += thread.steals;
+       total.remote_tasks += thread.remote_tasks;
+       total.displaced_tasks += thread.displaced_tasks;
+       total.range_splits += thread.range_splits;
+       total.idle_time_ns += thread.idle_time_ns;
+       total.barrier_wait_ns += thread.barrier_wait_ns;
+       total.work_search_ns += thread.work_search_ns;
+   }
+   fill_derived_metrics(&total);
+   *out = total;
+}
+
+
+uint64_t scheduler_predict_cost_ns(TaskScheduler* sched, void (*func)(void*), TaskWeight weight,
+                                   size_t size_hint) {
+   return cost_model_predict(&sched->cost_model, cost_model_key(func, cost_size_class(size_hint)), weight);
 }
 
 
@@ -226,6 +1699,25 @@ void scheduler_print_metrics(TaskScheduler* sched) {
    printf("Tasks Completed: %lu\n", completed);
    printf("Total Execution Time: %.2f ms\n", total_time / 1e6);
    printf("Avg Task Time: %.3f ms\n", completed > 0 ? (total_time / 1e6) / completed : 0);
+   if (sched->mode == SCHEDULE_ADAPTIVE) {
+       static const char* names[] = {"STATIC", "DYNAMIC", "GUIDED", "HETEROGENEOUS", "ADAPTIVE", "WORK_STEALING", "LPT"};
+       printf("Adaptive Selection: %s\n", names[sched->adaptive_mode]);
+   }
+   if (sched->mode == SCHEDULE_WORK_STEALING || sched->adaptive_mode == SCHEDULE_WORK_STEALING) {
+       printf("Steals: %lu / %lu attempts\n", sched->metrics.steals, sched->metrics.steal_attempts);
+   }
+   if (sched->num_nodes > 1) {
+       printf("Remote Node Tasks: %lu\n", sched->metrics.remote_tasks);
+   }
+   printf("Idle Time: %.2f ms (barrier %.2f ms, work search %.2f ms), idle ratio %.3f\n",
+          sched->metrics.idle_time_ns / 1e6, sched->metrics.barrier_wait_ns / 1e6,
+          sched->metrics.work_search_ns / 1e6, sched->metrics.idle_ratio);
+   for (int t = 0; t < sched->num_threads; t++) {
+       RuntimeMetrics thread;
+       scheduler_get_thread_metrics(sched, t, &thread);
+       printf("  Thread %2d: tasks=%lu busy=%.2f ms idle=%.2f ms\n", t, thread.tasks_completed,
+              thread.total_exec_time_ns / 1e6, thread.idle_time_ns / 1e6);
+   }
 }
 
 
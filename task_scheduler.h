@@ -1,61 +1,298 @@
 #ifndef TASK_SCHEDULER_H
 #define TASK_SCHEDULER_H
 #include <omp.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "affinity.h"
+#include "arena.h"
+#include "cost_model.h"
+#include "task.h"
+#include "task_queue.h"
+#include "timing.h"
+#include "topology.h"
+#include "trace.h"
+#include "ws_deque.h"
 
-typedef enum {
-   TASK_LIGHT = 1,
-   TASK_MEDIUM = 2,
-   TASK_HEAVY = 3
-} TaskWeight;
-
-typedef struct {
-   void (*func)(void*);
-   void* arg;
-   TaskWeight weight;
-   int id;
-} Task;
+#define ADAPTIVE_DEFAULT_VARIANCE_THRESHOLD 0.5
+#define ADAPTIVE_PROBE_FRACTION 8
+#define ADAPTIVE_PROBE_MIN_PER_THREAD 4
+#define ADAPTIVE_STEAL_MIN_PER_THREAD 256
+// Range tasks run grain iterations between split checks, aiming for about
+// this many nanoseconds, with a grain of at most 1/(threads * this) of the
+// range.
+#define PARALLEL_FOR_TARGET_NS 50000
+#define PARALLEL_FOR_MIN_LEAVES_PER_THREAD 4
 
 typedef enum {
    SCHEDULE_STATIC,
    SCHEDULE_DYNAMIC,
    SCHEDULE_GUIDED,
    SCHEDULE_HETEROGENEOUS,
-   SCHEDULE_ADAPTIVE
+   SCHEDULE_ADAPTIVE,
+   SCHEDULE_WORK_STEALING,
+   SCHEDULE_LPT
 } ScheduleMode;
 
+// How run_task charges execution time. SAMPLED times one task in every
+// timing_sample_rate; CHUNKED reads the clock once per timing_sample_rate
+// tasks and charges the whole span, dispatch included, from the start of
+// the chunk's first task. A worker's partial chunk is charged when its
+// share of the batch is done. Both extrapolate total_exec_time_ns from the
+// timed share.
+typedef enum {
+   TIMING_EVERY_TASK,
+   TIMING_SAMPLED,
+   TIMING_CHUNKED
+} TimingMode;
+
+typedef struct TaskNode TaskNode;
+typedef struct TaskEdge TaskEdge;
+
+// Tasks spawned into a group; scheduler_sync returns once all of them,
+// and everything they spawned into the same group, have finished.
+typedef struct {
+   _Atomic(int64_t) pending;
+} TaskGroup;
+
 typedef struct {
    uint64_t tasks_completed;
    uint64_t total_exec_time_ns;
    uint64_t idle_time_ns;
+   uint64_t barrier_wait_ns;
+   uint64_t work_search_ns;
    uint64_t queue_accesses;
+   uint64_t steal_attempts;
+   uint64_t steals;
+   uint64_t remote_tasks;
+   uint64_t displaced_tasks;
+   uint64_t range_splits;
    double avg_exec_time_ms;
    double idle_ratio;
 } RuntimeMetrics;
 
+// Per-worker counters on their own cache line. Only the owning worker writes
+// them; they are folded into RuntimeMetrics when the pool goes idle.
 typedef struct {
-   Task* task_queue;
+   alignas(64) _Atomic(uint64_t) tasks_completed;
+   _Atomic(uint64_t) timed_tasks;
+   _Atomic(uint64_t) timed_ticks;
+   _Atomic(uint64_t) steal_attempts;
+   _Atomic(uint64_t) steals;
+   _Atomic(uint64_t) remote_tasks;
+   _Atomic(uint64_t) displaced_tasks;
+   _Atomic(uint64_t) range_splits;
+   _Atomic(uint64_t) barrier_ticks;
+   _Atomic(uint64_t) search_ticks;
+   uint64_t chunk_start;
+   int sample_countdown;
+   bool chunk_open;
+} WorkerStats;
+
+// Next unstarted entry of one worker's LPT list; thieves advance it too.
+typedef struct {
+   alignas(64) _Atomic(int) next;
+} LptCursor;
+
+// Tasks submitted for one NUMA node or one worker, claimed alongside the
+// shared queue. Local workers drain its batch first; next is the shared
+// cursor.
+typedef struct {
+   TaskQueue queue;
+   size_t batch_base;
+   int batch_count;
+   alignas(64) _Atomic(int) next;
+} LocalQueue;
+
+typedef struct {
+   TaskQueue queue;
    int capacity;
-   int head;
-   int tail;
-   int active_tasks;
+   size_t batch_base;
   
    int num_threads;
    ScheduleMode mode;
    RuntimeMetrics metrics;
+   WorkerStats* worker_stats;
+   TimingMode timing_mode;
+   int timing_sample_rate;
+   TaskArena arena;
+   CostModel cost_model;
+   TraceBuffer* trace;
+   char* trace_path;
+   uint64_t trace_origin;
+   WSDeque* deques;
+   WSDeque* ready;
+   _Atomic(int64_t) ready_inflight;
+   // Both raised by every submit (active_tasks before it touches the arena
+   // or a queue), so they get a line of their own rather than sharing one
+   // with batch_base, which every dispatch reads. next_task_id numbers the
+   // submissions of an epoch; traces use it as the task id.
+   alignas(64) _Atomic(int) active_tasks;
+   _Atomic(int) next_task_id;
+   // Workers that found no ready task on their last search.
+   alignas(64) _Atomic(int) idle_workers;
+   _Atomic(TaskNode*) dag_nodes;
   
    bool running;
    double variance_threshold;
+   ScheduleMode adaptive_mode;
+  
+   int* worker_cpus;
+   const Topology* topology;
+   int num_nodes;
+   LocalQueue* node_queues;
+   LocalQueue* worker_queues;
+   bool pool_ready;
+   pthread_t pool_thread;
+   pthread_mutex_t pool_lock;
+   pthread_cond_t work_cv;
+   pthread_cond_t done_cv;
+   uint64_t run_requests;
+   uint64_t runs_served;
+   // A run was requested since the last scheduler_wait returned.
+   bool run_since_wait;
+   // Threads outside the pool blocked in scheduler_sync; a group's last
+   // task wakes them through done_cv.
+   _Atomic(int) sync_waiters;
+   bool shutdown;
+  
+   // Shared by the worker team; written inside omp single/master.
+   bool pool_exit;
+   size_t batch_count;
+   int local_batch_count;
+   int adaptive_probe;
+   uint64_t* probe_durations;
+   uint64_t* probe_busy;
+   // Partitioning engines' view of the batch as parallel arrays: predicted
+   // cost per batch position, and index permutations into the batch in
+   // place of copied tasks. Grown to the largest batch and kept across runs.
+   uint64_t* batch_costs;
+   int* batch_order;
+   int* batch_sorted;
+   int* batch_aux;
+   int batch_scratch_capacity;
+   // Per-worker partial sums and histogram rows (two buckets, or one per
+   // worker) of the engines' parallel prologue.
+   double* prologue_sums;
+   int* prologue_counts;
+   int* lpt_bounds;
+   LptCursor* lpt_cursors;
 } TaskScheduler;
 
+// capacity only sizes the initial queue segments; the queue grows on demand,
+// so submission always succeeds and returns true.
 void scheduler_init(TaskScheduler* sched, int num_threads, int capacity, ScheduleMode mode);
-void scheduler_submit(TaskScheduler* sched, void (*func)(void*), void* arg, TaskWeight weight);
+// As scheduler_init, with workers pinned according to placement (NULL or
+// PLACEMENT_NONE leaves them to the OS). Returns 0 once every worker is
+// pinned as planned, or -1 if the plan was rejected or a worker could not
+// be pinned; scheduler_worker_cpu reports the mapping either way, with -1
+// for an unpinned worker.
+int scheduler_init_placed(TaskScheduler* sched, int num_threads, int capacity, ScheduleMode mode,
+                          const PlacementConfig* placement);
+int scheduler_worker_cpu(TaskScheduler* sched, int tid);
+// Topology of pinned workers; an unpinned worker has no node (-1) and shares
+// nothing.
+int scheduler_worker_node(TaskScheduler* sched, int tid);
+bool scheduler_workers_share(TaskScheduler* sched, int tid_a, int tid_b, TopoLevel level);
+bool scheduler_submit(TaskScheduler* sched, void (*func)(void*), void* arg, TaskWeight weight);
+// As scheduler_submit, with a hint of the task's input size (0 for none).
+// The cost model keys its estimate on func and the power-of-two class of
+// the hint; weight only seeds the estimate until func has been measured.
+bool scheduler_submit_sized(TaskScheduler* sched, void (*func)(void*), void* arg, TaskWeight weight,
+                            size_t size_hint);
+// Copies size bytes of arg into the task's queue slot (or the argument arena
+// when larger than TASK_INLINE_ARG_SIZE) and passes func a pointer to the
+// copy. The pointer is only valid while the task runs.
+bool scheduler_submit_inline(TaskScheduler* sched, void (*func)(void*), const void* arg, size_t size,
+                             TaskWeight weight);
+// As scheduler_submit_inline, queued for the workers on NUMA node node so
+// the task runs where its data was first touched. Workers elsewhere only
+// take it once their own node is drained. A node outside the topology
+// (e.g. -1) means no preference.
+bool scheduler_submit_on_node(TaskScheduler* sched, void (*func)(void*), const void* arg, size_t size,
+                              TaskWeight weight, int node);
+// As scheduler_submit_inline, with an affinity key: tasks sharing a key go
+// to the same worker (scheduler_key_worker), in every batch, so data they
+// share stays in its cache. An idle worker may still take them, trying
+// workers on its own L3 first.
+bool scheduler_submit_keyed(TaskScheduler* sched, void (*func)(void*), const void* arg, size_t size,
+                            TaskWeight weight, uint64_t key);
+int scheduler_key_worker(TaskScheduler* sched, uint64_t key);
+// Node of the worker that a static split of count items over the team gives
+// index to, or -1 if that worker is not pinned. Data initialised by a task
+// submitted to this node is first-touched where later tasks for the same
+// index will run.
+int scheduler_home_node(TaskScheduler* sched, int index, int count);
+// Submits func to run once every task in deps has completed. The returned
+// handle can be passed as a dependency of later submissions and stays valid
+// until scheduler_reset or scheduler_destroy.
+TaskNode* scheduler_submit_after(TaskScheduler* sched, TaskNode** deps, int ndeps,
+                                 void (*func)(void*), void* arg, TaskWeight weight);
+// Fork-join from inside running tasks. Spawned tasks go to the calling
+// worker's ready deque, where idle workers can steal them; arg is not
+// copied. scheduler_sync runs ready tasks while it waits instead of
+// blocking the worker. Called from outside the pool, spawned tasks join the
+// shared queue and scheduler_sync starts a run to execute them.
+void scheduler_group_init(TaskGroup* group);
+void scheduler_spawn(TaskScheduler* sched, TaskGroup* group, void (*func)(void*), void* arg, TaskWeight weight);
+void scheduler_sync(TaskScheduler* sched, TaskGroup* group);
+// Runs body over [begin, end) and returns once all of it has run. The range
+// starts as one task per worker; each runs grain iterations at a time and
+// hands the upper half of what is left to its ready deque only while
+// another worker is idle, so the range is split no finer than the machine
+// needs. The grain comes from body's measured per-iteration cost and the
+// team size. Usable inside tasks; from outside the pool, call it while the
+// pool is idle.
+void scheduler_parallel_for(TaskScheduler* sched, int begin, int end,
+                            void (*body)(int begin, int end, void* ctx), void* ctx);
+// As scheduler_parallel_for without waiting: the per-worker ranges are
+// queued on the home node of their part of [begin, end) and run with the
+// next batch. ctx must stay valid until then.
+void scheduler_submit_splittable(TaskScheduler* sched, int begin, int end,
+                                 void (*body)(int begin, int end, void* ctx), void* ctx);
+// Submits count tasks at once: task i runs func((char*)base_arg + i * stride)
+// (stride 0 passes base_arg to all). They are held as one descriptor in the
+// argument arena and expanded as they run, through the same lazily split
+// per-worker ranges as scheduler_submit_splittable, so completed-task
+// counts see those ranges rather than the individual calls.
+bool scheduler_submit_range(TaskScheduler* sched, void (*func)(void*), void* base_arg, size_t stride,
+                            int count, TaskWeight weight);
+int scheduler_parallel_for_grain(TaskScheduler* sched, void (*body)(int begin, int end, void* ctx), int count);
+void scheduler_set_timing(TaskScheduler* sched, TimingMode mode, int sample_rate);
+// Opt-in: record every task execution per worker and write a Chrome
+// trace-event JSON file to path at scheduler_destroy.
+void scheduler_enable_trace(TaskScheduler* sched, const char* path);
+// Argument storage owned by the scheduler. Released in bulk when
+// scheduler_wait returns with no task left in flight, so it must only back
+// tasks submitted before that wait.
+void* scheduler_alloc_arg(TaskScheduler* sched, size_t size);
 void scheduler_run(TaskScheduler* sched);
+// Returns once the pool is idle. If scheduler_run was called since the last
+// wait, that includes every task submitted before this call, even one that
+// arrived after the pool's last claim.
 void scheduler_wait(TaskScheduler* sched);
+// Starts a new epoch on an idle scheduler: waits for the current run, frees
+// the task-graph handles, zeroes the run metrics and restarts task ids. Queue segments, arena
+// blocks, the worker pool and the learned costs carry over, so a batch
+// after a reset allocates nothing a batch before it did not. Returns false,
+// changing nothing, while submitted tasks are still waiting for a run.
+bool scheduler_reset(TaskScheduler* sched);
 void scheduler_destroy(TaskScheduler* sched);
 
+// Learned execution time of func at size_hint, in nanoseconds. Updated from
+// timed task executions each time a batch completes (CHUNKED timing does not
+// feed it). Call while the pool is idle.
+uint64_t scheduler_predict_cost_ns(TaskScheduler* sched, void (*func)(void*), TaskWeight weight,
+                                   size_t size_hint);
+
 void scheduler_print_metrics(TaskScheduler* sched);
+// Live totals summed from the per-worker counters, safe to call while the
+// pool is running. sched->metrics holds the same totals as of the last time
+// the pool went idle; read it only while idle.
+void scheduler_snapshot_metrics(TaskScheduler* sched, RuntimeMetrics* out);
+void scheduler_get_thread_metrics(TaskScheduler* sched, int tid, RuntimeMetrics* out);
 double scheduler_get_throughput(TaskScheduler* sched, double duration_sec);
 double scheduler_get_efficiency(TaskScheduler* sched);
 
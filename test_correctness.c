@@ -1,7 +1,13 @@
+#define _GNU_SOURCE
 #include "task_scheduler.h"
 #include "workloads.h"
+#include <sched.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <assert.h>
+#include <unistd.h>
 
 
 void dummy_task(void* arg) {
@@ -11,7 +17,190 @@ void dummy_task(void* arg) {
 }
 
 
+void slow_task(void* arg) {
+   usleep(100000);
+   dummy_task(arg);
+}
+
+
+typedef struct {
+   int* log;
+   int* next_slot;
+   int value;
+} ChainStep;
+
+
+void chain_task(void* arg) {
+   ChainStep* step = (ChainStep*)arg;
+   int slot;
+   #pragma omp atomic capture
+   slot = (*step->next_slot)++;
+   step->log[slot] = step->value;
+}
+
+
+typedef struct {
+   int* counter;
+   int seen;
+} JoinCheck;
+
+
+void join_task(void* arg) {
+   JoinCheck* check = (JoinCheck*)arg;
+   #pragma omp atomic read
+   check->seen = *check->counter;
+}
+
+
+void arena_arg_task(void* arg) {
+   dummy_task(*(int**)arg);
+}
+
+
+typedef struct {
+   long* sum;
+   long value;
+} InlineArg;
+
+typedef struct {
+   InlineArg head;
+   char pad[48];
+} WideArg;
+
+void inline_arg_task(void* arg) {
+   InlineArg* a = arg;
+   #pragma omp atomic
+   *a->sum += a->value;
+}
+
+
+void sized_sleep_task(void* arg) {
+   usleep(*(int*)arg);
+}
+
+
+typedef struct {
+   int cpu;
+   int off_cpu;
+} CpuCheck;
+
+
+void cpu_check_task(void* arg) {
+   CpuCheck* check = arg;
+   if (sched_getcpu() != check->cpu) {
+       #pragma omp atomic
+       check->off_cpu++;
+   }
+}
+
+
+typedef struct {
+   int* off_node;
+   int node;
+} NodeCheck;
+
+void node_check_task(void* arg) {
+   NodeCheck* check = arg;
+   if (topology_domain(topology_get(), sched_getcpu(), TOPO_NODE) != check->node) {
+       #pragma omp atomic
+       (*check->off_node)++;
+   }
+}
+
+
+typedef struct {
+   int* ran;
+   int* displaced;
+   int worker;
+} KeyCheck;
+
+void key_check_task(void* arg) {
+   KeyCheck* check = arg;
+   #pragma omp atomic
+   (*check->ran)++;
+   if (omp_get_thread_num() != check->worker) {
+       #pragma omp atomic
+       (*check->displaced)++;
+   }
+}
+
+
+typedef struct {
+   TaskScheduler* sched;
+   int n;
+   long result;
+} FibArg;
+
+void fib_task(void* arg) {
+   FibArg* fib = arg;
+   if (fib->n < 2) {
+       fib->result = fib->n;
+       return;
+   }
+   FibArg a = {fib->sched, fib->n - 1, 0};
+   FibArg b = {fib->sched, fib->n - 2, 0};
+   TaskGroup group;
+   scheduler_group_init(&group);
+   scheduler_spawn(fib->sched, &group, fib_task, &a, TASK_LIGHT);
+   fib_task(&b);
+   scheduler_sync(fib->sched, &group);
+   fib->result = a.result + b.result;
+}
+
+
+typedef struct {
+   TaskScheduler* sched;
+   ReductionTask* reduction;
+   int n;
+} NestedFor;
+
+void nested_for_task(void* arg) {
+   NestedFor* nested = arg;
+   scheduler_parallel_for(nested->sched, 0, nested->n, reduction_range, nested->reduction);
+}
+
+
+// The first quarter of the 20000 items is far heavier than the rest.
+void visit_range(int begin, int end, void* ctx) {
+   int* visits = ctx;
+   for (int i = begin; i < end; i++) {
+       volatile double x = 0.0;
+       int reps = i < 5000 ? 10000 : 20;
+       for (int k = 0; k < reps; k++) x += k;
+       visits[i]++;
+   }
+}
+
+
+void increment_task(void* arg) {
+   (*(int*)arg)++;
+}
+
+
+// Wider than TASK_INLINE_ARG_SIZE, so the copy lives in the arena.
+typedef struct {
+   int* count;
+   int* corrupt;
+   long value;
+   long multiples[4];
+} CheckedArg;
+
+void checked_arg_task(void* arg) {
+   CheckedArg* a = arg;
+   for (int k = 0; k < 4; k++) {
+       if (a->multiples[k] != a->value * (k + 1)) {
+           #pragma omp atomic
+           (*a->corrupt)++;
+           break;
+       }
+   }
+   #pragma omp atomic
+   (*a->count)++;
+}
+
+
 int main() {
+   int failures = 0;
    printf("=== CORRECTNESS TESTS ===\n\n");
   
    printf("Test 1: Basic task submission...");
@@ -34,10 +223,11 @@ int main() {
    }
    scheduler_destroy(&sched);
   
-   const char* modes[] = {"STATIC", "DYNAMIC", "GUIDED", "HETEROGENEOUS"};
-   ScheduleMode mode_vals[] = {SCHEDULE_STATIC, SCHEDULE_DYNAMIC, SCHEDULE_GUIDED, SCHEDULE_HETEROGENEOUS};
+   const char* modes[] = {"STATIC", "DYNAMIC", "GUIDED", "HETEROGENEOUS", "WORK_STEALING", "ADAPTIVE"};
+   ScheduleMode mode_vals[] = {SCHEDULE_STATIC, SCHEDULE_DYNAMIC, SCHEDULE_GUIDED, SCHEDULE_HETEROGENEOUS,
+                               SCHEDULE_WORK_STEALING, SCHEDULE_ADAPTIVE};
   
-   for (int m = 0; m < 4; m++) {
+   for (int m = 0; m < 6; m++) {
        printf("Test %d: %s scheduling...", m+2, modes[m]);
        scheduler_init(&sched, 4, 1000, mode_vals[m]);
       
@@ -58,7 +248,829 @@ int main() {
        scheduler_destroy(&sched);
    }
   
+   printf("Test 8: Concurrent multi-producer submission...");
+   scheduler_init(&sched, 4, 1024, SCHEDULE_DYNAMIC);
+  
+   counter = 0;
+   int rejected = 0;
+   #pragma omp parallel num_threads(4)
+   {
+       for (int i = 0; i < 250; i++) {
+           if (!scheduler_submit(&sched, dummy_task, &counter, TASK_LIGHT)) {
+               #pragma omp atomic
+               rejected++;
+           }
+       }
+   }
+  
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   printf(" counter=%d rejected=%d (expected 1000, 0)", counter, rejected);
+   if (counter == 1000 && rejected == 0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 9: Submission beyond the capacity hint grows the queue...");
+   scheduler_init(&sched, 2, 8, SCHEDULE_STATIC);
+  
+   counter = 0;
+   int accepted = 0;
+   for (int i = 0; i < 5000; i++) {
+       if (scheduler_submit(&sched, dummy_task, &counter, TASK_LIGHT)) accepted++;
+   }
+  
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   printf(" accepted=%d counter=%d (expected 5000, 5000)", accepted, counter);
+   if (accepted == 5000 && counter == 5000) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 10: Asynchronous run picks up late submissions...");
+   scheduler_init(&sched, 4, 1024, SCHEDULE_DYNAMIC);
+  
+   counter = 0;
+   scheduler_submit(&sched, slow_task, &counter, TASK_HEAVY);
+   scheduler_run(&sched);
+   int counter_at_return = counter;
+   for (int i = 0; i < 100; i++) {
+       scheduler_submit(&sched, dummy_task, &counter, TASK_LIGHT);
+   }
+   scheduler_wait(&sched);
+  
+   printf(" at_return=%d counter=%d (expected 0, 101)", counter_at_return, counter);
+   if (counter_at_return == 0 && counter == 101) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 11: Persistent pool across repeated batches...");
+   counter = 0;
+   for (int batch = 0; batch < 20; batch++) {
+       for (int i = 0; i < 50; i++) {
+           scheduler_submit(&sched, dummy_task, &counter, TASK_LIGHT);
+       }
+       scheduler_run(&sched);
+       scheduler_wait(&sched);
+   }
+  
+   printf(" counter=%d (expected 1000)", counter);
+   if (counter == 1000) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 12: Dependency chain runs in order...");
+   scheduler_init(&sched, 4, 1024, SCHEDULE_WORK_STEALING);
+  
+   int log[200];
+   int next_slot = 0;
+   ChainStep steps[200];
+   TaskNode* prev = NULL;
+   for (int i = 0; i < 200; i++) {
+       steps[i].log = log;
+       steps[i].next_slot = &next_slot;
+       steps[i].value = i;
+       prev = scheduler_submit_after(&sched, prev ? &prev : NULL, prev ? 1 : 0, chain_task, &steps[i], TASK_LIGHT);
+   }
+  
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   int in_order = (next_slot == 200);
+   for (int i = 0; in_order && i < 200; i++) {
+       if (log[i] != i) in_order = 0;
+   }
+   printf(" executed=%d ordered=%d (expected 200, 1)", next_slot, in_order);
+   if (in_order) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 13: Fan-out/fan-in graph...");
+   counter = 0;
+   JoinCheck check = {&counter, -1};
+   TaskNode* root = scheduler_submit_after(&sched, NULL, 0, dummy_task, &counter, TASK_LIGHT);
+   TaskNode* middle[64];
+   for (int i = 0; i < 64; i++) {
+       middle[i] = scheduler_submit_after(&sched, &root, 1, dummy_task, &counter, TASK_LIGHT);
+   }
+   scheduler_submit_after(&sched, middle, 64, join_task, &check, TASK_LIGHT);
+  
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   printf(" counter=%d join_saw=%d (expected 65, 65)", counter, check.seen);
+   if (counter == 65 && check.seen == 65) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 14: Dependency on an already finished task...");
+   counter = 0;
+   scheduler_submit_after(&sched, &root, 1, dummy_task, &counter, TASK_LIGHT);
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   printf(" counter=%d (expected 1)", counter);
+   if (counter == 1) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 15: Per-thread metrics fold into totals...");
+   scheduler_init(&sched, 4, 1024, SCHEDULE_GUIDED);
+  
+   counter = 0;
+   for (int i = 0; i < 500; i++) {
+       scheduler_submit(&sched, dummy_task, &counter, TASK_LIGHT);
+   }
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   uint64_t per_thread_sum = 0;
+   for (int t = 0; t < sched.num_threads; t++) {
+       RuntimeMetrics thread;
+       scheduler_get_thread_metrics(&sched, t, &thread);
+       per_thread_sum += thread.tasks_completed;
+   }
+   RuntimeMetrics snapshot;
+   scheduler_snapshot_metrics(&sched, &snapshot);
+  
+   printf(" completed=%lu per_thread=%lu in_flight=%d (expected 500, 500, 0)",
+          sched.metrics.tasks_completed, per_thread_sum, sched.active_tasks);
+   if (sched.metrics.tasks_completed == 500 && per_thread_sum == 500 &&
+       snapshot.tasks_completed == 500 && sched.active_tasks == 0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 16: Clock source converts ticks to nanoseconds...");
+   uint64_t tick_start = timing_now();
+   usleep(20000);
+   uint64_t slept_ns = timing_ticks_to_ns(timing_now() - tick_start);
+  
+   printf(" source=%s slept=%.1fms (expected ~20ms)",
+          timing_source() == CLOCK_SOURCE_TSC ? "TSC" : "MONOTONIC", slept_ns / 1e6);
+   if (slept_ns >= 19000000ULL && slept_ns < 200000000ULL) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   const char* timing_names[] = {"SAMPLED", "CHUNKED"};
+   TimingMode timing_vals[] = {TIMING_SAMPLED, TIMING_CHUNKED};
+  
+   for (int m = 0; m < 2; m++) {
+       printf("Test %d: %s timing extrapolates totals...", 17 + m, timing_names[m]);
+       scheduler_init(&sched, 4, 2048, SCHEDULE_STATIC);
+       scheduler_set_timing(&sched, timing_vals[m], 16);
+      
+       counter = 0;
+       for (int i = 0; i < 2000; i++) {
+           scheduler_submit(&sched, dummy_task, &counter, TASK_LIGHT);
+       }
+       scheduler_run(&sched);
+       scheduler_wait(&sched);
+      
+       printf(" counter=%d completed=%lu time=%s", counter, sched.metrics.tasks_completed,
+              sched.metrics.total_exec_time_ns > 0 ? "set" : "zero");
+       if (counter == 2000 && sched.metrics.tasks_completed == 2000 && sched.metrics.total_exec_time_ns > 0) {
+           printf(" PASS\n");
+       } else {
+           printf(" FAIL\n");
+           failures++;
+       }
+       scheduler_destroy(&sched);
+   }
+  
+   printf("Test 19: Idle time is measured on an imbalanced batch...");
+   scheduler_init(&sched, 4, 64, SCHEDULE_STATIC);
+  
+   counter = 0;
+   scheduler_submit(&sched, slow_task, &counter, TASK_HEAVY);
+   for (int i = 0; i < 7; i++) {
+       scheduler_submit(&sched, dummy_task, &counter, TASK_LIGHT);
+   }
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   uint64_t idle_sum = 0;
+   for (int t = 0; t < sched.num_threads; t++) {
+       RuntimeMetrics thread;
+       scheduler_get_thread_metrics(&sched, t, &thread);
+       idle_sum += thread.idle_time_ns;
+   }
+   double efficiency = scheduler_get_efficiency(&sched);
+  
+   printf(" idle=%.1fms efficiency=%.2f ratio=%.2f", sched.metrics.idle_time_ns / 1e6, efficiency,
+          sched.metrics.idle_ratio);
+   if (sched.metrics.idle_time_ns > 0 && idle_sum == sched.metrics.idle_time_ns &&
+       efficiency < 1.0 && sched.metrics.idle_ratio > 0.0 && sched.metrics.avg_exec_time_ms > 0.0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 20: Chrome trace export...");
+   const char* trace_file = "test_correctness_trace.json";
+   // ADAPTIVE starts cold, so its batch goes through the probe phase too.
+   ScheduleMode trace_modes[] = {SCHEDULE_HETEROGENEOUS, SCHEDULE_ADAPTIVE};
+   int events[2] = {0, 0};
+   int bad_ids = 0;
+   for (int m = 0; m < 2; m++) {
+       scheduler_init(&sched, 4, 256, trace_modes[m]);
+       scheduler_enable_trace(&sched, trace_file);
+      
+       // Keyed tasks and graph nodes travel through other queues, but their
+       // ids must not collide with the shared queue's.
+       counter = 0;
+       for (int i = 0; i < 120; i++) {
+           scheduler_submit(&sched, dummy_task, &counter, (TaskWeight)(1 + i % 3));
+       }
+       int* traced_counter = &counter;
+       for (int i = 0; i < 8; i++) {
+           scheduler_submit_keyed(&sched, arena_arg_task, &traced_counter, sizeof(traced_counter), TASK_LIGHT, i);
+       }
+       TaskNode* root = scheduler_submit_after(&sched, NULL, 0, dummy_task, &counter, TASK_LIGHT);
+       scheduler_submit_after(&sched, &root, 1, dummy_task, &counter, TASK_LIGHT);
+       scheduler_run(&sched);
+       scheduler_wait(&sched);
+       scheduler_destroy(&sched);
+      
+       char line[512];
+       char seen_ids[130] = {0};
+       FILE* trace = fopen(trace_file, "r");
+       while (trace && fgets(line, sizeof(line), trace)) {
+           if (!strstr(line, "\"ph\":\"X\"")) continue;
+           events[m]++;
+           int id = -1;
+           char* args = strstr(line, "\"args\":{\"id\":");
+           if (args) sscanf(args + strlen("\"args\":{\"id\":"), "%d", &id);
+           if (id < 0 || id >= 130 || seen_ids[id]++) bad_ids++;
+       }
+       if (trace) fclose(trace);
+       remove(trace_file);
+   }
+  
+   printf(" events=%d,%d bad_ids=%d (expected 130,130, 0)", events[0], events[1], bad_ids);
+   if (events[0] == 130 && events[1] == 130 && bad_ids == 0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 21: Arena-backed task arguments...");
+   scheduler_init(&sched, 4, 8192, SCHEDULE_DYNAMIC);
+  
+   int arena_ok = 1;
+   uint64_t allocs_first_epoch = 0;
+   for (int epoch = 0; epoch < 3; epoch++) {
+       counter = 0;
+       for (int i = 0; i < 5000; i++) {
+           int** arg = scheduler_alloc_arg(&sched, sizeof(int*));
+           *arg = &counter;
+           scheduler_submit(&sched, arena_arg_task, arg, TASK_LIGHT);
+       }
+       scheduler_run(&sched);
+       scheduler_wait(&sched);
+       if (counter != 5000) arena_ok = 0;
+       if (epoch == 0) allocs_first_epoch = sched.arena.system_allocs;
+   }
+  
+   printf(" counter=%d system_allocs=%lu (expected 5000, unchanged after epoch 1)", counter,
+          sched.arena.system_allocs);
+   if (arena_ok && sched.arena.system_allocs == allocs_first_epoch) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 22: Inline task arguments...");
+   scheduler_init(&sched, 4, 8192, SCHEDULE_WORK_STEALING);
+  
+   long inline_sum = 0;
+   long expected_sum = 0;
+   for (int i = 1; i <= 4000; i++) {
+       if (i % 4 == 0) {
+           // Too large for the slot: copied to the arena instead.
+           WideArg wide = {{&inline_sum, i}, {0}};
+           scheduler_submit_inline(&sched, inline_arg_task, &wide, sizeof(wide), TASK_LIGHT);
+       } else {
+           InlineArg small = {&inline_sum, i};
+           scheduler_submit_inline(&sched, inline_arg_task, &small, sizeof(small), TASK_LIGHT);
+       }
+       expected_sum += i;
+   }
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   printf(" sum=%ld (expected %ld)", inline_sum, expected_sum);
+   if (inline_sum == expected_sum) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 23: Segments are recycled while producers race the pool...");
+   scheduler_init(&sched, 4, 1024, SCHEDULE_DYNAMIC);
+  
+   int segments_ok = 1;
+   for (int epoch = 0; epoch < 4; epoch++) {
+       counter = 0;
+       scheduler_run(&sched);
+       #pragma omp parallel num_threads(4)
+       {
+           for (int i = 0; i < 5000; i++) {
+               scheduler_submit(&sched, dummy_task, &counter, TASK_LIGHT);
+           }
+       }
+       scheduler_run(&sched);
+       scheduler_wait(&sched);
+       if (counter != 20000) segments_ok = 0;
+   }
+  
+   printf(" counter=%d (expected 20000 every epoch)", counter);
+   if (segments_ok && task_queue_size(&sched.queue) == 0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 24: LPT scheduling of mixed weights...");
+   scheduler_init(&sched, 4, 1024, SCHEDULE_LPT);
+  
+   counter = 0;
+   for (int i = 0; i < 300; i++) {
+       scheduler_submit(&sched, dummy_task, &counter, (TaskWeight)(TASK_LIGHT + i % 3));
+   }
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   printf(" counter=%d (expected 300)", counter);
+   if (counter == 300) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 25: Cost model learns per-function, per-size costs...");
+   scheduler_init(&sched, 2, 1024, SCHEDULE_LPT);
+  
+   // Both sizes are labelled LIGHT; only the size hint tells them apart.
+   int small_us = 200, large_us = 4000;
+   for (int i = 0; i < 8; i++) {
+       scheduler_submit_sized(&sched, sized_sleep_task, &small_us, TASK_LIGHT, small_us);
+       scheduler_submit_sized(&sched, sized_sleep_task, &large_us, TASK_LIGHT, large_us);
+   }
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   double small_ms = scheduler_predict_cost_ns(&sched, sized_sleep_task, TASK_LIGHT, small_us) / 1e6;
+   double large_ms = scheduler_predict_cost_ns(&sched, sized_sleep_task, TASK_LIGHT, large_us) / 1e6;
+   printf(" small=%.2fms large=%.2fms (expected ~0.2, ~4)", small_ms, large_ms);
+   if (small_ms >= 0.2 && small_ms < 2.0 && large_ms >= 4.0 && large_ms < 8.0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf("Test 26: Explicit placement pins workers...");
+   // Pin to the first CPU this process may run on, which need not be 0.
+   cpu_set_t allowed;
+   CPU_ZERO(&allowed);
+   sched_getaffinity(0, sizeof(allowed), &allowed);
+   int allowed_cpu = 0;
+   while (allowed_cpu < CPU_SETSIZE - 1 && !CPU_ISSET(allowed_cpu, &allowed)) allowed_cpu++;
+   int pin_list[] = {allowed_cpu};
+   PlacementConfig pin_config = {PLACEMENT_EXPLICIT, pin_list, 1};
+   int pinned = scheduler_init_placed(&sched, 2, 1024, SCHEDULE_DYNAMIC, &pin_config);
+  
+   CpuCheck on_cpu = {allowed_cpu, 0};
+   for (int i = 0; i < 200; i++) {
+       scheduler_submit(&sched, cpu_check_task, &on_cpu, TASK_LIGHT);
+   }
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+   int cpu0 = scheduler_worker_cpu(&sched, 0), cpu1 = scheduler_worker_cpu(&sched, 1);
+   scheduler_destroy(&sched);
+  
+   int bad_list[] = {CPU_SETSIZE - 1};
+   PlacementConfig bad_config = {PLACEMENT_EXPLICIT, bad_list, 1};
+   int rejected_plan = scheduler_init_placed(&sched, 2, 1024, SCHEDULE_DYNAMIC, &bad_config);
+   int unpinned = scheduler_worker_cpu(&sched, 0);
+   scheduler_destroy(&sched);
+  
+   printf(" result=%d map=%d,%d off_cpu=%d bad=%d/%d (expected 0, %d,%d, 0, -1/-1)",
+          pinned, cpu0, cpu1, on_cpu.off_cpu, rejected_plan, unpinned, allowed_cpu, allowed_cpu);
+   if (pinned == 0 && cpu0 == allowed_cpu && cpu1 == allowed_cpu && on_cpu.off_cpu == 0 && rejected_plan == -1 &&
+       unpinned == -1) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 27: Topology levels nest and cover every CPU...");
+   const Topology* topo = topology_get();
+   int topo_ok = topo->ncpus >= 1;
+   for (int i = 0; i < topo->ncpus && topo_ok; i++) {
+       const TopoCpu* a = &topo->cpus[i];
+       for (int l = 0; l < TOPO_LEVELS; l++) {
+           if (a->domain[l] < 0 || a->domain[l] >= topo->ndomains[l]) topo_ok = 0;
+       }
+       if (topology_domain(topo, a->cpu, TOPO_CORE) != a->domain[TOPO_CORE]) topo_ok = 0;
+       for (int j = 0; j < topo->ncpus; j++) {
+           const TopoCpu* b = &topo->cpus[j];
+           if (a->domain[TOPO_CORE] == b->domain[TOPO_CORE] && a->domain[TOPO_L3] != b->domain[TOPO_L3]) topo_ok = 0;
+           if (a->domain[TOPO_L3] == b->domain[TOPO_L3] && a->domain[TOPO_PACKAGE] != b->domain[TOPO_PACKAGE]) topo_ok = 0;
+       }
+   }
+  
+   int first_cpu = topo->cpus[0].cpu;
+   PlacementConfig topo_config = {PLACEMENT_EXPLICIT, &first_cpu, 1};
+   scheduler_init_placed(&sched, 2, 1024, SCHEDULE_STATIC, &topo_config);
+   int node = scheduler_worker_node(&sched, 0);
+   int shared = scheduler_workers_share(&sched, 0, 1, TOPO_CORE);
+   scheduler_destroy(&sched);
+  
+   printf(" cpus=%d cores=%d l3=%d packages=%d nodes=%d worker_node=%d shared=%d",
+          topo->ncpus, topo->ndomains[TOPO_CORE], topo->ndomains[TOPO_L3], topo->ndomains[TOPO_PACKAGE],
+          topo->ndomains[TOPO_NODE], node, shared);
+   if (topo_ok && node >= 0 && shared) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 28: Node-hinted tasks run on their home node...");
+   scheduler_init_placed(&sched, 2, 1024, SCHEDULE_STATIC, &topo_config);
+   int off_node = 0, unhinted = 0;
+   for (int i = 0; i < 300; i++) {
+       NodeCheck check = {&off_node, scheduler_home_node(&sched, i, 300)};
+       scheduler_submit_on_node(&sched, node_check_task, &check, sizeof(check), TASK_LIGHT, check.node);
+       if (i % 3 == 0) {
+           int* counter = &unhinted;
+           scheduler_submit_on_node(&sched, arena_arg_task, &counter, sizeof(counter), TASK_LIGHT,
+                                    i % 2 ? -1 : topo->ndomains[TOPO_NODE]);
+       }
+   }
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+   RuntimeMetrics node_metrics;
+   scheduler_snapshot_metrics(&sched, &node_metrics);
+   scheduler_destroy(&sched);
+  
+   printf(" completed=%lu off_node=%d unhinted=%d remote=%lu (expected 400, 0, 100, 0)",
+          node_metrics.tasks_completed, off_node, unhinted, node_metrics.remote_tasks);
+   if (node_metrics.tasks_completed == 400 && off_node == 0 && unhinted == 100 && node_metrics.remote_tasks == 0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 29: Keyed tasks go to their key's worker across batches...");
+   scheduler_init(&sched, 3, 64, SCHEDULE_DYNAMIC);
+   int keyed_ran = 0, keyed_displaced = 0;
+   for (int batch = 0; batch < 2; batch++) {
+       for (int i = 0; i < 2000; i++) {
+           KeyCheck check = {&keyed_ran, &keyed_displaced, scheduler_key_worker(&sched, i)};
+           scheduler_submit_keyed(&sched, key_check_task, &check, sizeof(check), TASK_LIGHT, i);
+       }
+       scheduler_run(&sched);
+       scheduler_wait(&sched);
+   }
+   RuntimeMetrics key_metrics;
+   scheduler_snapshot_metrics(&sched, &key_metrics);
+   int key_map = scheduler_key_worker(&sched, 7);
+   scheduler_destroy(&sched);
+  
+   printf(" ran=%d displaced=%d/%lu key_worker(7)=%d (expected 4000, equal counts, 1)",
+          keyed_ran, keyed_displaced, key_metrics.displaced_tasks, key_map);
+   if (keyed_ran == 4000 && (uint64_t)keyed_displaced == key_metrics.displaced_tasks && key_map == 1) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 30: Nested spawn/sync from inside tasks...");
+   scheduler_init(&sched, 4, 64, SCHEDULE_STATIC);
+   FibArg fib = {&sched, 18, 0};
+   scheduler_submit(&sched, fib_task, &fib, TASK_HEAVY);
+   int sort_n = 200000;
+   int* sort_data = malloc(sizeof(int) * sort_n);
+   run_quicksort_workload(&sched, sort_data, sort_n);
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+  
+   int unsorted = 0;
+   for (int i = 1; i < sort_n; i++) {
+       if (sort_data[i - 1] > sort_data[i]) unsorted++;
+   }
+   free(sort_data);
+  
+   // From outside the pool, sync starts the run itself.
+   TaskGroup outer;
+   scheduler_group_init(&outer);
+   int outer_count = 0;
+   for (int i = 0; i < 50; i++) {
+       scheduler_spawn(&sched, &outer, dummy_task, &outer_count, TASK_LIGHT);
+   }
+   scheduler_sync(&sched, &outer);
+  
+   // ... and blocks rather than spinning while the group sleeps.
+   for (int i = 0; i < 4; i++) {
+       scheduler_spawn(&sched, &outer, slow_task, &outer_count, TASK_LIGHT);
+   }
+   struct timespec cpu_start, cpu_end;
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+   scheduler_sync(&sched, &outer);
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+   double sync_cpu_ms = (cpu_end.tv_sec - cpu_start.tv_sec) * 1e3 + (cpu_end.tv_nsec - cpu_start.tv_nsec) / 1e6;
+   scheduler_wait(&sched);
+   int spawn_active = sched.active_tasks;
+   scheduler_destroy(&sched);
+  
+   printf(" fib(18)=%ld unsorted=%d outer=%d active=%d sync_cpu=%.1fms (expected 2584, 0, 54, 0, <20ms)",
+          fib.result, unsorted, outer_count, spawn_active, sync_cpu_ms);
+   if (fib.result == 2584 && unsorted == 0 && outer_count == 54 && spawn_active == 0 && sync_cpu_ms < 20.0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 31: parallel_for picks a grain and covers the range...");
+   scheduler_init(&sched, 4, 64, SCHEDULE_DYNAMIC);
+   int for_n = 100000;
+   int* ones = malloc(sizeof(int) * for_n);
+   for (int i = 0; i < for_n; i++) ones[i] = 1;
+   long for_sum = 0;
+   ReductionTask for_ctx = {ones, 0, 0, &for_sum};
+  
+   int cold_grain = scheduler_parallel_for_grain(&sched, reduction_range, for_n);
+   scheduler_parallel_for(&sched, 0, for_n, reduction_range, &for_ctx);
+   scheduler_wait(&sched);
+   int warm_grain = scheduler_parallel_for_grain(&sched, reduction_range, for_n);
+   scheduler_parallel_for(&sched, 0, 5, reduction_range, &for_ctx);
+   scheduler_parallel_for(&sched, 7, 7, reduction_range, &for_ctx);
+   scheduler_wait(&sched);
+  
+   ReductionTask reduction;
+   setup_reduction_workload(&sched, &reduction, 50);
+   NestedFor nested = {&sched, &for_ctx, for_n};
+   scheduler_submit(&sched, nested_for_task, &nested, TASK_HEAVY);
+   run_reduction_workload(&sched, &reduction);
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+   int for_active = sched.active_tasks;
+   scheduler_destroy(&sched);
+   free(ones);
+  
+   printf(" sum=%ld reduction=%ld grain=%d->%d active=%d (expected %d, 50, 6250->1..6250, 0)",
+          for_sum, *reduction.result, cold_grain, warm_grain, for_active, 2 * for_n + 5);
+   if (for_sum == 2 * for_n + 5 && *reduction.result == 50 && cold_grain == 6250 && warm_grain >= 1 &&
+       warm_grain <= cold_grain && for_active == 0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 32: Splittable ranges split only for idle workers...");
+   int split_n = 20000;
+   int* visits = calloc(split_n, sizeof(int));
+   uint64_t splits[2];
+   for (int k = 0; k < 2; k++) {
+       scheduler_init(&sched, k == 0 ? 1 : 4, 64, SCHEDULE_STATIC);
+       scheduler_submit_splittable(&sched, 0, split_n, visit_range, visits);
+       scheduler_run(&sched);
+       scheduler_wait(&sched);
+       RuntimeMetrics split_metrics;
+       scheduler_snapshot_metrics(&sched, &split_metrics);
+       splits[k] = split_metrics.range_splits;
+       scheduler_destroy(&sched);
+   }
+   int bad_visits = 0;
+   for (int i = 0; i < split_n; i++) {
+       if (visits[i] != 2) bad_visits++;
+   }
+   free(visits);
+  
+   printf(" bad_visits=%d splits(1 worker)=%lu splits(4 workers)=%lu (expected 0, 0, >0)",
+          bad_visits, splits[0], splits[1]);
+   if (bad_visits == 0 && splits[0] == 0 && splits[1] > 0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 33: Bulk range submission expands every task...");
+   scheduler_init(&sched, 4, 64, SCHEDULE_DYNAMIC);
+   int bulk_n = 10000;
+   int* cells = calloc(bulk_n, sizeof(int));
+   int shared_count = 0;
+   uint64_t light_prior = scheduler_predict_cost_ns(&sched, chain_task, TASK_LIGHT, 0);
+   scheduler_submit_range(&sched, increment_task, cells, sizeof(int), bulk_n, TASK_LIGHT);
+   scheduler_submit_range(&sched, dummy_task, &shared_count, 0, 5000, TASK_LIGHT);
+   scheduler_submit_range(&sched, dummy_task, &shared_count, 0, 0, TASK_LIGHT);
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+   int bulk_bad = 0;
+   for (int i = 0; i < bulk_n; i++) {
+       if (cells[i] != 1) bulk_bad++;
+   }
+   uint64_t unit_cost;
+   bool learned = cost_model_lookup(&sched.cost_model, cost_model_key(increment_task, 0), &unit_cost);
+   int bulk_active = sched.active_tasks;
+   // Range wrappers must not feed the weight-class prior of unrelated tasks.
+   bool prior_kept = scheduler_predict_cost_ns(&sched, chain_task, TASK_LIGHT, 0) == light_prior;
+   scheduler_destroy(&sched);
+   free(cells);
+  
+   printf(" bad=%d shared=%d learned=%d active=%d prior_kept=%d (expected 0, 5000, 1, 0, 1)", bulk_bad,
+          shared_count, learned, bulk_active, prior_kept);
+   if (bulk_bad == 0 && shared_count == 5000 && learned && bulk_active == 0 && prior_kept) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 34: Reset epochs reuse the scheduler...");
+   scheduler_init(&sched, 4, 64, SCHEDULE_DYNAMIC);
+   int epochs = 200;
+   int epoch_count = 0;
+   int epoch_bad = 0;
+   uint64_t arena_allocs = 0;
+   for (int e = 0; e < epochs; e++) {
+       int* cell = scheduler_alloc_arg(&sched, sizeof(int));
+       *cell = 0;
+       TaskNode* first = scheduler_submit_after(&sched, NULL, 0, dummy_task, cell, TASK_LIGHT);
+       scheduler_submit_after(&sched, &first, 1, dummy_task, cell, TASK_LIGHT);
+       for (int i = 0; i < 50; i++) {
+           scheduler_submit(&sched, dummy_task, &epoch_count, TASK_LIGHT);
+       }
+       scheduler_run(&sched);
+       scheduler_wait(&sched);
+       RuntimeMetrics epoch_metrics;
+       scheduler_snapshot_metrics(&sched, &epoch_metrics);
+       if (*cell != 2 || epoch_metrics.tasks_completed != 52) epoch_bad++;
+       if (e == 0) arena_allocs = sched.arena.system_allocs;
+       if (!scheduler_reset(&sched)) epoch_bad++;
+   }
+   bool arena_kept = sched.arena.system_allocs == arena_allocs;
+   bool nodes_freed = atomic_load(&sched.dag_nodes) == NULL;
+   bool costs_kept = cost_model_lookup(&sched.cost_model, cost_model_key(dummy_task, 0), &unit_cost);
+  
+   // Submitted but not yet run: the reset must leave the batch alone.
+   scheduler_submit(&sched, dummy_task, &epoch_count, TASK_LIGHT);
+   bool refused = !scheduler_reset(&sched);
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+   scheduler_destroy(&sched);
+  
+   printf(" count=%d bad_epochs=%d arena_kept=%d nodes_freed=%d costs_kept=%d refused=%d (expected %d, 0, 1, 1, 1, 1)",
+          epoch_count, epoch_bad, arena_kept, nodes_freed, costs_kept, refused, epochs * 50 + 1);
+   if (epoch_count == epochs * 50 + 1 && epoch_bad == 0 && arena_kept && nodes_freed && costs_kept && refused) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 35: Tasks submitted right after scheduler_run are waited for...");
+   scheduler_init(&sched, 4, 64, SCHEDULE_DYNAMIC);
+   int late_count = 0;
+   int stranded = 0;
+   int rounds = 2000;
+   for (int r = 0; r < rounds; r++) {
+       scheduler_run(&sched);
+       scheduler_submit(&sched, dummy_task, &late_count, TASK_LIGHT);
+       scheduler_wait(&sched);
+       if (sched.active_tasks != 0) stranded++;
+   }
+   scheduler_destroy(&sched);
+  
+   printf(" count=%d stranded=%d (expected %d, 0)", late_count, stranded, rounds);
+   if (late_count == rounds && stranded == 0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   printf("Test 36: Arena arguments survive waits that race a producer...");
+   scheduler_init(&sched, 4, 1024, SCHEDULE_DYNAMIC);
+   int checked_count = 0;
+   int corrupt = 0;
+   int producing = 1;
+   int checked_tasks = 20000;
+   #pragma omp parallel num_threads(2)
+   {
+       if (omp_get_thread_num() == 0) {
+           for (int i = 0; i < checked_tasks; i++) {
+               CheckedArg a = {&checked_count, &corrupt, i, {i, 2L * i, 3L * i, 4L * i}};
+               scheduler_submit_inline(&sched, checked_arg_task, &a, sizeof(a), TASK_LIGHT);
+           }
+           #pragma omp atomic write
+           producing = 0;
+       } else {
+           int more = 1;
+           while (more) {
+               scheduler_run(&sched);
+               scheduler_wait(&sched);
+               #pragma omp atomic read
+               more = producing;
+           }
+       }
+   }
+   scheduler_run(&sched);
+   scheduler_wait(&sched);
+   scheduler_destroy(&sched);
+  
+   printf(" count=%d corrupt=%d (expected %d, 0)", checked_count, corrupt, checked_tasks);
+   if (checked_count == checked_tasks && corrupt == 0) {
+       printf(" PASS\n");
+   } else {
+       printf(" FAIL\n");
+       failures++;
+   }
+  
+   // Two tasks per worker, far fewer than the sample rate.
+   for (int m = 0; m < 2; m++) {
+       printf("Test %d: %s timing charges a batch smaller than the sample rate...", 37 + m, timing_names[m]);
+       scheduler_init(&sched, 4, 64, SCHEDULE_STATIC);
+       scheduler_set_timing(&sched, timing_vals[m], 64);
+      
+       int sleep_us = 1000;
+       for (int i = 0; i < 8; i++) {
+           scheduler_submit(&sched, sized_sleep_task, &sleep_us, TASK_LIGHT);
+       }
+       scheduler_run(&sched);
+       scheduler_wait(&sched);
+      
+       int untimed = 0;
+       for (int t = 0; t < 4; t++) {
+           RuntimeMetrics thread;
+           scheduler_get_thread_metrics(&sched, t, &thread);
+           if (thread.tasks_completed > 0 && thread.total_exec_time_ns == 0) untimed++;
+       }
+       printf(" completed=%lu exec=%.1fms untimed_workers=%d (expected 8, >0, 0)", sched.metrics.tasks_completed,
+              sched.metrics.total_exec_time_ns / 1e6, untimed);
+       if (sched.metrics.tasks_completed == 8 && sched.metrics.total_exec_time_ns > 0 && untimed == 0) {
+           printf(" PASS\n");
+       } else {
+           printf(" FAIL\n");
+           failures++;
+       }
+       scheduler_destroy(&sched);
+   }
+  
    printf("\nALL TESTS COMPLETED!\n");
    printf("All scheduling modes executed successfully.\n");
-   return 0;
+   return failures > 0 ? 1 : 0;
 }
@@ -0,0 +1,68 @@
+#include "timing.h"
+#include <pthread.h>
+#ifdef TIMING_HAVE_TSC
+#include <cpuid.h>
+#endif
+
+#define TIMING_CALIBRATION_NS 10000000ULL
+
+int timing_use_tsc = 0;
+uint64_t timing_ns_per_tick_q32 = 1ULL << 32;
+
+static pthread_mutex_t timing_lock = PTHREAD_MUTEX_INITIALIZER;
+static int timing_calibrated = 0;
+static int timing_selected = 0;
+
+
+#ifdef TIMING_HAVE_TSC
+static int cpu_has_invariant_tsc(void) {
+   unsigned int eax, ebx, ecx, edx;
+   if (__get_cpuid_max(0x80000000, NULL) < 0x80000007) return 0;
+   if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return 0;
+   return (edx >> 8) & 1;
+}
+
+
+static void calibrate_tsc(void) {
+   uint64_t ns_start = timing_monotonic_ns();
+   uint64_t tsc_start = __rdtsc();
+   uint64_t ns_end;
+   do {
+       ns_end = timing_monotonic_ns();
+   } while (ns_end - ns_start < TIMING_CALIBRATION_NS);
+   uint64_t tsc_end = __rdtsc();
+  
+   timing_ns_per_tick_q32 = (uint64_t)(((unsigned __int128)(ns_end - ns_start) << 32) / (tsc_end - tsc_start));
+   timing_calibrated = 1;
+}
+#endif
+
+
+ClockSource timing_init(ClockSource requested) {
+   pthread_mutex_lock(&timing_lock);
+  
+   if (requested == CLOCK_SOURCE_AUTO && timing_selected) {
+       pthread_mutex_unlock(&timing_lock);
+       return timing_source();
+   }
+  
+   int use_tsc = 0;
+#ifdef TIMING_HAVE_TSC
+   if (requested != CLOCK_SOURCE_MONOTONIC && cpu_has_invariant_tsc()) {
+       if (!timing_calibrated) calibrate_tsc();
+       use_tsc = 1;
+   }
+#else
+   (void)requested;
+#endif
+   timing_use_tsc = use_tsc;
+   timing_selected = 1;
+  
+   pthread_mutex_unlock(&timing_lock);
+   return timing_source();
+}
+
+
+ClockSource timing_source(void) {
+   return timing_use_tsc ? CLOCK_SOURCE_TSC : CLOCK_SOURCE_MONOTONIC;
+}
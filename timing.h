@@ -0,0 +1,46 @@
+#ifndef TIMING_H
+#define TIMING_H
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TIMING_HAVE_TSC 1
+#endif
+
+// Timestamp source for task timing. Reads return raw ticks; convert deltas
+// with timing_ticks_to_ns. The TSC is used only when the CPU reports an
+// invariant TSC, and is calibrated once against CLOCK_MONOTONIC.
+
+typedef enum {
+   CLOCK_SOURCE_AUTO,
+   CLOCK_SOURCE_TSC,
+   CLOCK_SOURCE_MONOTONIC
+} ClockSource;
+
+extern int timing_use_tsc;
+extern uint64_t timing_ns_per_tick_q32;
+
+// Returns the source actually selected. AUTO keeps an earlier choice, so an
+// explicit selection must be made before any scheduler is created.
+ClockSource timing_init(ClockSource requested);
+ClockSource timing_source(void);
+
+static inline uint64_t timing_monotonic_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint64_t timing_now(void) {
+#ifdef TIMING_HAVE_TSC
+   if (timing_use_tsc) return __rdtsc();
+#endif
+   return timing_monotonic_ns();
+}
+
+static inline uint64_t timing_ticks_to_ns(uint64_t ticks) {
+   if (!timing_use_tsc) return ticks;
+   return (uint64_t)(((unsigned __int128)ticks * timing_ns_per_tick_q32) >> 32);
+}
+
+#endif
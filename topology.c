@@ -0,0 +1,193 @@
+#include "topology.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SYSFS_CPU "/sys/devices/system/cpu"
+#define SYSFS_NODE "/sys/devices/system/node"
+
+static Topology topology;
+static pthread_once_t topology_once = PTHREAD_ONCE_INIT;
+
+
+static bool read_line(const char* path, char* buf, size_t size) {
+   FILE* f = fopen(path, "r");
+   if (!f) return false;
+   bool ok = fgets(buf, (int)size, f) != NULL;
+   fclose(f);
+   return ok;
+}
+
+
+static int read_int(const char* path, int fallback) {
+   char buf[64];
+   return read_line(path, buf, sizeof(buf)) ? atoi(buf) : fallback;
+}
+
+
+// Parses a sysfs CPU list such as "0-3,8,10-11" into out (up to max
+// entries); returns the number of CPUs.
+static int parse_cpulist(const char* list, int* out, int max) {
+   int n = 0;
+   const char* p = list;
+   while (*p && *p != '\n') {
+       char* end;
+       long lo = strtol(p, &end, 10);
+       if (end == p) break;
+       long hi = lo;
+       p = end;
+       if (*p == '-') {
+           hi = strtol(p + 1, &end, 10);
+           p = end;
+       }
+       for (long c = lo; c <= hi && n < max; c++) out[n++] = (int)c;
+       if (*p == ',') p++;
+   }
+   return n;
+}
+
+
+// Maps raw ids (which may be sparse) to dense ones in order of appearance.
+static int dense_id(int* keys, int* nkeys, int key) {
+   for (int i = 0; i < *nkeys; i++) {
+       if (keys[i] == key) return i;
+   }
+   keys[*nkeys] = key;
+   return (*nkeys)++;
+}
+
+
+// L3 domains are keyed by the first CPU sharing the cache, which is
+// globally unique; a CPU without an L3 entry falls back to its package.
+static int l3_key(int cpu, int package) {
+   char path[128], buf[256];
+   for (int index = 0; index < 8; index++) {
+       snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/level", cpu, index);
+       int level = read_int(path, -1);
+       if (level < 0) break;
+       if (level != 3) continue;
+       snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+       int first;
+       if (read_line(path, buf, sizeof(buf)) && parse_cpulist(buf, &first, 1) == 1) return first;
+   }
+   return -1 - package;
+}
+
+
+static int cmp_compact(const void* a, const void* b) {
+   const TopoCpu* x = a;
+   const TopoCpu* y = b;
+   if (x->domain[TOPO_PACKAGE] != y->domain[TOPO_PACKAGE]) return x->domain[TOPO_PACKAGE] - y->domain[TOPO_PACKAGE];
+   if (x->domain[TOPO_CORE] != y->domain[TOPO_CORE]) return x->domain[TOPO_CORE] - y->domain[TOPO_CORE];
+   return x->cpu - y->cpu;
+}
+
+
+static void topology_parse(void) {
+   Topology* t = &topology;
+   char buf[4096], path[128];
+  
+   int max = (int)sysconf(_SC_NPROCESSORS_CONF);
+   if (max < 1) max = 1;
+   int* online = malloc(sizeof(int) * max);
+   int n = read_line(SYSFS_CPU "/online", buf, sizeof(buf)) ? parse_cpulist(buf, online, max) : 0;
+   if (n == 0) {
+       n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+       if (n < 1 || n > max) n = 1;
+       for (int i = 0; i < n; i++) online[i] = i;
+   }
+  
+   t->ncpus = n;
+   t->cpus = malloc(sizeof(TopoCpu) * n);
+   t->max_cpu = 0;
+   for (int i = 0; i < n; i++) {
+       if (online[i] + 1 > t->max_cpu) t->max_cpu = online[i] + 1;
+   }
+   t->index_of_cpu = malloc(sizeof(int) * t->max_cpu);
+   int* node_of_cpu = malloc(sizeof(int) * t->max_cpu);
+   for (int c = 0; c < t->max_cpu; c++) node_of_cpu[c] = 0;
+  
+   int* nodes = malloc(sizeof(int) * max);
+   int nnodes = read_line(SYSFS_NODE "/online", buf, sizeof(buf)) ? parse_cpulist(buf, nodes, max) : 0;
+   for (int i = 0; i < nnodes; i++) {
+       snprintf(path, sizeof(path), SYSFS_NODE "/node%d/cpulist", nodes[i]);
+       if (!read_line(path, buf, sizeof(buf))) continue;
+       int* members = malloc(sizeof(int) * max);
+       int count = parse_cpulist(buf, members, max);
+       for (int k = 0; k < count; k++) {
+           if (members[k] < t->max_cpu) node_of_cpu[members[k]] = nodes[i];
+       }
+       free(members);
+   }
+  
+   // Raw keys per level, made dense below.
+   int* keys[TOPO_LEVELS];
+   int nkeys[TOPO_LEVELS] = {0};
+   for (int l = 0; l < TOPO_LEVELS; l++) keys[l] = malloc(sizeof(int) * n);
+   int* core_keys = malloc(sizeof(int) * n * 2);
+   int ncore_keys = 0;
+  
+   for (int i = 0; i < n; i++) {
+       int cpu = online[i];
+       snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/physical_package_id", cpu);
+       int package = read_int(path, 0);
+       snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/core_id", cpu);
+       int core = read_int(path, cpu);
+      
+       TopoCpu* tc = &t->cpus[i];
+       tc->cpu = cpu;
+       tc->domain[TOPO_PACKAGE] = dense_id(keys[TOPO_PACKAGE], &nkeys[TOPO_PACKAGE], package);
+       tc->domain[TOPO_L3] = dense_id(keys[TOPO_L3], &nkeys[TOPO_L3], l3_key(cpu, package));
+       tc->domain[TOPO_NODE] = dense_id(keys[TOPO_NODE], &nkeys[TOPO_NODE], node_of_cpu[cpu]);
+      
+       // core_id is only unique within a package.
+       int c;
+       for (c = 0; c < ncore_keys; c++) {
+           if (core_keys[2 * c] == package && core_keys[2 * c + 1] == core) break;
+       }
+       if (c == ncore_keys) {
+           core_keys[2 * c] = package;
+           core_keys[2 * c + 1] = core;
+           ncore_keys++;
+       }
+       tc->domain[TOPO_CORE] = c;
+   }
+   nkeys[TOPO_CORE] = ncore_keys;
+  
+   qsort(t->cpus, n, sizeof(TopoCpu), cmp_compact);
+   for (int c = 0; c < t->max_cpu; c++) t->index_of_cpu[c] = -1;
+   for (int i = 0; i < n; i++) {
+       t->index_of_cpu[t->cpus[i].cpu] = i;
+       bool same_core = i > 0 && t->cpus[i].domain[TOPO_CORE] == t->cpus[i - 1].domain[TOPO_CORE];
+       t->cpus[i].smt = same_core ? t->cpus[i - 1].smt + 1 : 0;
+   }
+   for (int l = 0; l < TOPO_LEVELS; l++) {
+       t->ndomains[l] = nkeys[l];
+       free(keys[l]);
+   }
+  
+   free(core_keys);
+   free(nodes);
+   free(node_of_cpu);
+   free(online);
+}
+
+
+const Topology* topology_get(void) {
+   pthread_once(&topology_once, topology_parse);
+   return &topology;
+}
+
+
+int topology_domain(const Topology* topo, int cpu, TopoLevel level) {
+   if (cpu < 0 || cpu >= topo->max_cpu || topo->index_of_cpu[cpu] < 0) return -1;
+   return topo->cpus[topo->index_of_cpu[cpu]].domain[level];
+}
+
+
+bool topology_shares(const Topology* topo, int cpu_a, int cpu_b, TopoLevel level) {
+   int a = topology_domain(topo, cpu_a, level);
+   return a >= 0 && a == topology_domain(topo, cpu_b, level);
+}
@@ -0,0 +1,40 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+#include <stdbool.h>
+
+// Hardware topology of the online CPUs, read once from
+// /sys/devices/system/cpu and /sys/devices/system/node. Each CPU belongs to
+// one domain per level; core, L3 and package nest, while NUMA nodes may
+// span packages or split one. Domain ids are dense per level. Without
+// sysfs every CPU is its own core on a single L3, package and node.
+
+typedef enum {
+   TOPO_CORE,
+   TOPO_L3,
+   TOPO_PACKAGE,
+   TOPO_NODE,
+   TOPO_LEVELS
+} TopoLevel;
+
+typedef struct {
+   int cpu;
+   int smt;  // rank among the hardware threads of its core
+   int domain[TOPO_LEVELS];
+} TopoCpu;
+
+typedef struct {
+   int ncpus;
+   TopoCpu* cpus;  // compact order: package, core, then CPU number
+   int ndomains[TOPO_LEVELS];
+   int max_cpu;
+   int* index_of_cpu;  // OS CPU number -> index into cpus, or -1
+} Topology;
+
+// Parsed on first use; the result is shared and never freed.
+const Topology* topology_get(void);
+
+// -1 if cpu is not online.
+int topology_domain(const Topology* topo, int cpu, TopoLevel level);
+bool topology_shares(const Topology* topo, int cpu_a, int cpu_b, TopoLevel level);
+
+#endif
@@ -0,0 +1,69 @@
+#include "trace.h"
+#include "timing.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TRACE_INITIAL_CAPACITY 4096
+
+
+void trace_buffer_init(TraceBuffer* buf) {
+   buf->events = malloc(sizeof(TraceEvent) * TRACE_INITIAL_CAPACITY);
+   buf->count = 0;
+   buf->capacity = TRACE_INITIAL_CAPACITY;
+}
+
+
+void trace_buffer_destroy(TraceBuffer* buf) {
+   free(buf->events);
+   buf->events = NULL;
+   buf->count = 0;
+   buf->capacity = 0;
+}
+
+
+void trace_buffer_grow(TraceBuffer* buf) {
+   buf->capacity *= 2;
+   buf->events = realloc(buf->events, sizeof(TraceEvent) * buf->capacity);
+}
+
+
+static const char* weight_name(int weight) {
+   switch (weight) {
+       case 1: return "LIGHT";
+       case 2: return "MEDIUM";
+       case 3: return "HEAVY";
+       default: return "UNKNOWN";
+   }
+}
+
+
+static double ticks_to_us(uint64_t ticks) {
+   return timing_ticks_to_ns(ticks) / 1e3;
+}
+
+
+int trace_write_chrome(const char* path, TraceBuffer* buffers, int nthreads, uint64_t origin_ticks) {
+   FILE* out = fopen(path, "w");
+   if (!out) return -1;
+  
+   fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+   fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"task_scheduler\"}}");
+   for (int t = 0; t < nthreads; t++) {
+       fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}",
+               t, t);
+   }
+  
+   for (int t = 0; t < nthreads; t++) {
+       for (size_t i = 0; i < buffers[t].count; i++) {
+           TraceEvent* ev = &buffers[t].events[i];
+           uint64_t start = ev->start_ticks > origin_ticks ? ev->start_ticks - origin_ticks : 0;
+           fprintf(out, ",\n{\"name\":\"task %d\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                        "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%d,\"weight\":\"%s\"}}",
+                   ev->task_id, weight_name(ev->weight), t, ticks_to_us(start),
+                   ticks_to_us(ev->end_ticks - ev->start_ticks), ev->task_id, weight_name(ev->weight));
+       }
+   }
+  
+   fprintf(out, "\n]}\n");
+   return fclose(out) == 0 ? 0 : -1;
+}
@@ -0,0 +1,40 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-thread task execution records, written out as Chrome trace-event JSON
+// (loadable in chrome://tracing and ui.perfetto.dev). Each buffer is only
+// appended to by its owning worker.
+
+typedef struct {
+   uint64_t start_ticks;
+   uint64_t end_ticks;
+   int task_id;
+   int weight;
+} TraceEvent;
+
+typedef struct {
+   alignas(64) TraceEvent* events;
+   size_t count;
+   size_t capacity;
+} TraceBuffer;
+
+void trace_buffer_init(TraceBuffer* buf);
+void trace_buffer_destroy(TraceBuffer* buf);
+void trace_buffer_grow(TraceBuffer* buf);
+
+static inline void trace_record(TraceBuffer* buf, int task_id, int weight, uint64_t start, uint64_t end) {
+   if (buf->count == buf->capacity) trace_buffer_grow(buf);
+   TraceEvent* ev = &buf->events[buf->count++];
+   ev->start_ticks = start;
+   ev->end_ticks = end;
+   ev->task_id = task_id;
+   ev->weight = weight;
+}
+
+// Timestamps are written relative to origin_ticks. Returns 0 on success.
+int trace_write_chrome(const char* path, TraceBuffer* buffers, int nthreads, uint64_t origin_ticks);
+
+#endif
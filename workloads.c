@@ -12,33 +12,44 @@ void matrix_row_task(void* arg) {
        }
        task->C[task->row][j] = sum;
    }
-   free(task);
 }
 
-void run_matrix_workload(TaskScheduler* sched, int size) {
-   double** A = malloc(sizeof(double*) * size);
-   double** B = malloc(sizeof(double*) * size);
-   double** C = malloc(sizeof(double*) * size);
-  
-   for (int i = 0; i < size; i++) {
-       A[i] = malloc(sizeof(double) * size);
-       B[i] = malloc(sizeof(double) * size);
-       C[i] = malloc(sizeof(double) * size);
-       for (int j = 0; j < size; j++) {
-           A[i][j] = 1.5;
-           B[i][j] = 2.0;
-           C[i][j] = 0.0;
-       }
+// Allocates and fills one row of each matrix on the worker that runs it.
+void matrix_init_task(void* arg) {
+   MatrixTask* task = (MatrixTask*)arg;
+   double* a = malloc(sizeof(double) * task->size);
+   double* b = malloc(sizeof(double) * task->size);
+   double* c = malloc(sizeof(double) * task->size);
+   for (int j = 0; j < task->size; j++) {
+       a[j] = 1.5;
+       b[j] = 2.0;
+       c[j] = 0.0;
    }
+   task->A[task->row] = a;
+   task->B[task->row] = b;
+   task->C[task->row] = c;
+}
+
+// Rows are initialised by their own scheduler run and keyed by row block,
+// so each block is first touched, and later computed, by the same worker.
+void setup_matrix_workload(TaskScheduler* sched, MatrixTask* m, int size) {
+   *m = (MatrixTask){malloc(sizeof(double*) * size), malloc(sizeof(double*) * size),
+                     malloc(sizeof(double*) * size), 0, size};
   
    for (int i = 0; i < size; i++) {
-       MatrixTask* task = malloc(sizeof(MatrixTask));
-       task->A = A;
-       task->B = B;
-       task->C = C;
-       task->row = i;
-       task->size = size;
-       scheduler_submit(sched, matrix_row_task, task, TASK_HEAVY);
+       MatrixTask task = *m;
+       task.row = i;
+       scheduler_submit_keyed(sched, matrix_init_task, &task, sizeof(task), TASK_LIGHT, i / MATRIX_ROW_BLOCK);
+   }
+   scheduler_run(sched);
+   scheduler_wait(sched);
+}
+
+void run_matrix_workload(TaskScheduler* sched, const MatrixTask* m) {
+   for (int i = 0; i < m->size; i++) {
+       MatrixTask task = *m;
+       task.row = i;
+       scheduler_submit_keyed(sched, matrix_row_task, &task, sizeof(task), TASK_HEAVY, i / MATRIX_ROW_BLOCK);
    }
 }
 
@@ -50,30 +61,53 @@ void reduction_task(void* arg) {
    }
    #pragma omp atomic
    *(task->result) += sum;
-   free(task);
 }
 
-void run_reduction_workload(TaskScheduler* sched, int array_size) {
-   int* array = malloc(sizeof(int) * array_size);
-   for (int i = 0; i < array_size; i++) array[i] = 1;
-  
-   long* result = calloc(1, sizeof(long));
-   int chunk = array_size / 100;
+// parallel_for body; ctx is a ReductionTask whose start and end are unused.
+void reduction_range(int begin, int end, void* ctx) {
+   ReductionTask* task = (ReductionTask*)ctx;
+   long sum = 0;
+   for (int i = begin; i < end; i++) {
+       sum += task->array[i];
+   }
+   #pragma omp atomic
+   *(task->result) += sum;
+}
+
+void reduction_init_task(void* arg) {
+   ReductionTask* task = (ReductionTask*)arg;
+   for (int i = task->start; i < task->end; i++) {
+       task->array[i] = 1;
+   }
+}
+
+// The array is first touched in one chunk per worker, on the node of the
+// worker a static split gives it to.
+void setup_reduction_workload(TaskScheduler* sched, ReductionTask* r, int array_size) {
+   *r = (ReductionTask){malloc(sizeof(int) * array_size), 0, array_size, calloc(1, sizeof(long))};
+   int chunk = (array_size + sched->num_threads - 1) / sched->num_threads;
   
    for (int i = 0; i < array_size; i += chunk) {
-       ReductionTask* task = malloc(sizeof(ReductionTask));
-       task->array = array;
-       task->start = i;
-       task->end = (i + chunk > array_size) ? array_size : i + chunk;
-       task->result = result;
-       scheduler_submit(sched, reduction_task, task, TASK_LIGHT);
+       ReductionTask task = {r->array, i, (i + chunk > array_size) ? array_size : i + chunk, r->result};
+       scheduler_submit_on_node(sched, reduction_init_task, &task, sizeof(task), TASK_LIGHT,
+                                scheduler_home_node(sched, i, array_size));
    }
+   scheduler_run(sched);
+   scheduler_wait(sched);
+}
+
+// The sum is one splittable range, whose per-worker parts are queued on the
+// nodes that first touched them.
+void run_reduction_workload(TaskScheduler* sched, const ReductionTask* r) {
+   ReductionTask* ctx = scheduler_alloc_arg(sched, sizeof(ReductionTask));
+   *ctx = *r;
+   scheduler_submit_splittable(sched, r->start, r->end, reduction_range, ctx);
 }
 
 void light_task(void* arg) {
    volatile int sum = 0;
    for (int i = 0; i < 1000; i++) sum += i;
-   free(arg);
+   (void)arg;
 }
 
 
@@ -82,7 +116,7 @@ void medium_task(void* arg) {
    for (int i = 0; i < 10000; i++) {
        sum += sqrt((double)i);
    }
-   free(arg);
+   (void)arg;
 }
 
 void heavy_task(void* arg) {
@@ -90,32 +124,104 @@ void heavy_task(void* arg) {
    for (int i = 0; i < 100000; i++) {
        sum += sin((double)i) * cos((double)i);
    }
-   free(arg);
+   (void)arg;
 }
 
 void run_mixed_workload(TaskScheduler* sched, int num_tasks) {
    for (int i = 0; i < num_tasks; i++) {
-       int* dummy = malloc(sizeof(int));
        if (i % 3 == 0) {
-           scheduler_submit(sched, light_task, dummy, TASK_LIGHT);
+           scheduler_submit_inline(sched, light_task, &i, sizeof(int), TASK_LIGHT);
        } else if (i % 3 == 1) {
-           scheduler_submit(sched, medium_task, dummy, TASK_MEDIUM);
+           scheduler_submit_inline(sched, medium_task, &i, sizeof(int), TASK_MEDIUM);
        } else {
-           scheduler_submit(sched, heavy_task, dummy, TASK_HEAVY);
+           scheduler_submit_inline(sched, heavy_task, &i, sizeof(int), TASK_HEAVY);
        }
    }
 }
 
+void variable_task(void* arg) {
+   int n = *(int*)arg;
+   volatile double sum = 0.0;
+   for (int i = 0; i < n; i++) {
+       sum += sqrt((double)i);
+   }
+}
+
+// Every task is labelled MEDIUM, but sizes span two orders of magnitude;
+// only the size hint tells them apart.
+void run_variable_workload(TaskScheduler* sched, int num_tasks) {
+   unsigned int seed = 12345;
+   for (int i = 0; i < num_tasks; i++) {
+       int* n = scheduler_alloc_arg(sched, sizeof(int));
+       *n = 1000 << (rand_r(&seed) % 7);
+       scheduler_submit_sized(sched, variable_task, n, TASK_MEDIUM, *n);
+   }
+}
+
 void fine_grained_task(void* arg) {
     volatile int *val = (int*)arg;
     *val += 1;
 }
 
 void run_fine_grained_workload(TaskScheduler *sched, int num_tasks) {
-    int *dummy_arg = malloc(sizeof(int));
+    int *dummy_arg = scheduler_alloc_arg(sched, sizeof(int));
     *dummy_arg = 0;
     
     for (int i = 0; i < num_tasks; i++) {
         scheduler_submit(sched, fine_grained_task, dummy_arg, TASK_LIGHT);
     }
 }
+
+// The same tasks as run_fine_grained_workload, submitted as one range.
+void run_fine_grained_range_workload(TaskScheduler* sched, int num_tasks) {
+   int* dummy_arg = scheduler_alloc_arg(sched, sizeof(int));
+   *dummy_arg = 0;
+   scheduler_submit_range(sched, fine_grained_task, dummy_arg, 0, num_tasks, TASK_LIGHT);
+}
+
+
+static int int_cmp(const void* a, const void* b) {
+   int x = *(const int*)a, y = *(const int*)b;
+   return (x > y) - (x < y);
+}
+
+// Hoare partition around the middle element, then the left half is spawned
+// and the right half sorted in place before joining.
+void quicksort_task(void* arg) {
+   SortTask* task = (SortTask*)arg;
+   int* a = task->data;
+   int n = task->hi - task->lo;
+   if (n <= SORT_CUTOFF) {
+       qsort(a + task->lo, n, sizeof(int), int_cmp);
+       return;
+   }
+  
+   int pivot = a[task->lo + (n - 1) / 2];
+   int i = task->lo - 1, j = task->hi;
+   while (1) {
+       do i++; while (a[i] < pivot);
+       do j--; while (a[j] > pivot);
+       if (i >= j) break;
+       int tmp = a[i];
+       a[i] = a[j];
+       a[j] = tmp;
+   }
+  
+   SortTask left = {task->sched, a, task->lo, j + 1};
+   SortTask right = {task->sched, a, j + 1, task->hi};
+   TaskGroup group;
+   scheduler_group_init(&group);
+   scheduler_spawn(task->sched, &group, quicksort_task, &left, TASK_HEAVY);
+   quicksort_task(&right);
+   scheduler_sync(task->sched, &group);
+}
+
+// Fills data with pseudo-random values and submits one task that sorts it
+// by recursive spawning.
+void run_quicksort_workload(TaskScheduler* sched, int* data, int n) {
+   unsigned int seed = 12345;
+   for (int i = 0; i < n; i++) data[i] = rand_r(&seed);
+  
+   SortTask root = {sched, data, 0, n};
+   scheduler_submit_inline(sched, quicksort_task, &root, sizeof(root), TASK_HEAVY);
+}
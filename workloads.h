@@ -2,6 +2,9 @@
 #define WORKLOADS_H
 #include "task_scheduler.h"
 
+// Rows of one matrix block share an affinity key.
+#define MATRIX_ROW_BLOCK 8
+
 typedef struct {
    double** A;
    double** B;
@@ -10,8 +13,13 @@ typedef struct {
    int size;
 } MatrixTask;
 
+void matrix_init_task(void* arg);
 void matrix_row_task(void* arg);
-void run_matrix_workload(TaskScheduler* sched, int size);
+// Allocates size x size matrices into m (row unused) and first-touches
+// them. This runs the scheduler and waits, executing anything already
+// queued, so call it before submitting other work.
+void setup_matrix_workload(TaskScheduler* sched, MatrixTask* m, int size);
+void run_matrix_workload(TaskScheduler* sched, const MatrixTask* m);
 
 typedef struct {
    int* array;
@@ -20,14 +28,36 @@ typedef struct {
    long* result;
 } ReductionTask;
 
+void reduction_init_task(void* arg);
 void reduction_task(void* arg);
-void run_reduction_workload(TaskScheduler* sched, int array_size);
+void reduction_range(int begin, int end, void* ctx);
+// Allocates the array and result into r and first-touches the array; runs
+// and waits like setup_matrix_workload.
+void setup_reduction_workload(TaskScheduler* sched, ReductionTask* r, int array_size);
+void run_reduction_workload(TaskScheduler* sched, const ReductionTask* r);
 
 void light_task(void* arg);
 void medium_task(void* arg);
 void heavy_task(void* arg);
 void run_mixed_workload(TaskScheduler* sched, int num_tasks);
 
+void variable_task(void* arg);
+void run_variable_workload(TaskScheduler* sched, int num_tasks);
+
 void run_fine_grained_workload(TaskScheduler *sched, int num_tasks);
+void run_fine_grained_range_workload(TaskScheduler* sched, int num_tasks);
+
+// Ranges at or below this size are sorted serially.
+#define SORT_CUTOFF 2048
+
+typedef struct {
+   TaskScheduler* sched;
+   int* data;
+   int lo;
+   int hi;
+} SortTask;
+
+void quicksort_task(void* arg);
+void run_quicksort_workload(TaskScheduler* sched, int* data, int n);
 
 #endif
@@ -0,0 +1,114 @@
+#include "ws_deque.h"
+#include <stdlib.h>
+
+
+static WSDequeArray* ws_array_new(int64_t size) {
+   WSDequeArray* a = malloc(sizeof(WSDequeArray) + sizeof(_Atomic(int64_t)) * size);
+   a->size = size;
+   a->next_retired = NULL;
+   return a;
+}
+
+
+static int64_t round_up_pow2(int64_t n) {
+   int64_t p = 1;
+   while (p < n) p <<= 1;
+   return p;
+}
+
+
+void ws_deque_init(WSDeque* dq, int64_t initial_capacity) {
+   atomic_init(&dq->top, 0);
+   atomic_init(&dq->bottom, 0);
+   atomic_init(&dq->array, ws_array_new(round_up_pow2(initial_capacity < 16 ? 16 : initial_capacity)));
+   dq->retired = NULL;
+}
+
+
+void ws_deque_destroy(WSDeque* dq) {
+   free(atomic_load_explicit(&dq->array, memory_order_relaxed));
+   while (dq->retired) {
+       WSDequeArray* next = dq->retired->next_retired;
+       free(dq->retired);
+       dq->retired = next;
+   }
+}
+
+
+// Owner only. Thieves may still hold the old array, so it is retired rather
+// than freed and reclaimed in ws_deque_destroy.
+static WSDequeArray* ws_deque_grow(WSDeque* dq, WSDequeArray* a, int64_t top, int64_t bottom) {
+   WSDequeArray* grown = ws_array_new(a->size * 2);
+   for (int64_t i = top; i < bottom; i++) {
+       int64_t v = atomic_load_explicit(&a->buffer[i & (a->size - 1)], memory_order_relaxed);
+       atomic_store_explicit(&grown->buffer[i & (grown->size - 1)], v, memory_order_relaxed);
+   }
+   a->next_retired = dq->retired;
+   dq->retired = a;
+   atomic_store_explicit(&dq->array, grown, memory_order_release);
+   return grown;
+}
+
+
+void ws_deque_push(WSDeque* dq, int64_t value) {
+   int64_t b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+   int64_t t = atomic_load_explicit(&dq->top, memory_order_acquire);
+   WSDequeArray* a = atomic_load_explicit(&dq->array, memory_order_relaxed);
+
+   if (b - t > a->size - 1) {
+       a = ws_deque_grow(dq, a, t, b);
+   }
+
+   atomic_store_explicit(&a->buffer[b & (a->size - 1)], value, memory_order_relaxed);
+   atomic_thread_fence(memory_order_release);
+   atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+}
+
+
+int64_t ws_deque_pop(WSDeque* dq) {
+   int64_t b = atomic_load_explicit(&dq->bottom, memory_order_relaxed) - 1;
+   WSDequeArray* a = atomic_load_explicit(&dq->array, memory_order_relaxed);
+   atomic_store_explicit(&dq->bottom, b, memory_order_relaxed);
+   atomic_thread_fence(memory_order_seq_cst);
+   int64_t t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+
+   if (t > b) {
+       atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+       return WS_DEQUE_EMPTY;
+   }
+
+   int64_t value = atomic_load_explicit(&a->buffer[b & (a->size - 1)], memory_order_relaxed);
+   if (t == b) {
+       // Last element: race against thieves for it.
+       if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+                                                    memory_order_seq_cst, memory_order_relaxed)) {
+           value = WS_DEQUE_EMPTY;
+       }
+       atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+   }
+   return value;
+}
+
+
+int64_t ws_deque_steal(WSDeque* dq) {
+   int64_t t = atomic_load_explicit(&dq->top, memory_order_acquire);
+   atomic_thread_fence(memory_order_seq_cst);
+   int64_t b = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+
+   if (t >= b) return WS_DEQUE_EMPTY;
+
+   WSDequeArray* a = atomic_load_explicit(&dq->array, memory_order_acquire);
+   int64_t value = atomic_load_explicit(&a->buffer[t & (a->size - 1)], memory_order_relaxed);
+   if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+                                                memory_order_seq_cst, memory_order_relaxed)) {
+       return WS_DEQUE_ABORT;
+   }
+   return value;
+}
+
+
+int64_t ws_deque_size(WSDeque* dq) {
+   int64_t b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+   int64_t t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+   return b > t ? b - t : 0;
+}
@@ -0,0 +1,34 @@
+#ifndef WS_DEQUE_H
+#define WS_DEQUE_H
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Chase-Lev work-stealing deque holding task indices.
+// The owning thread pushes and pops at the bottom (LIFO); any other thread
+// may steal from the top (FIFO). Memory orderings follow Le et al. (PPoPP'13).
+
+#define WS_DEQUE_EMPTY (-1)
+#define WS_DEQUE_ABORT (-2)
+
+typedef struct WSDequeArray {
+   int64_t size;
+   struct WSDequeArray* next_retired;
+   _Atomic(int64_t) buffer[];
+} WSDequeArray;
+
+typedef struct {
+   alignas(64) _Atomic(int64_t) top;
+   alignas(64) _Atomic(int64_t) bottom;
+   _Atomic(WSDequeArray*) array;
+   WSDequeArray* retired;
+} WSDeque;
+
+void ws_deque_init(WSDeque* dq, int64_t initial_capacity);
+void ws_deque_destroy(WSDeque* dq);
+void ws_deque_push(WSDeque* dq, int64_t value);
+int64_t ws_deque_pop(WSDeque* dq);
+int64_t ws_deque_steal(WSDeque* dq);
+int64_t ws_deque_size(WSDeque* dq);
+
+#endif